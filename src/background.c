@@ -38,20 +38,27 @@
 #include <wayland-server.h>
 #include <compositor.h>
 #include "unstable/background/background-unstable-v2-server-protocol.h"
+#include "weston-wall.h"
+#include "trace.h"
+#include "stats.h"
+#include "quota.h"
+#include "output-registry.h"
 
 #define MIN(a,b) (((a) < (b)) ? (a) : (b))
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
+/* Not in the wayland-wall protocol yet, the next free error code */
+#define WESTON_BACKGROUND_ERROR_INVALID_BUFFER (ZWW_BACKGROUND_V2_ERROR_BOUND + 1)
+
 struct weston_background {
     struct weston_compositor *compositor;
     struct wl_resource *binding;
     struct weston_layer layer;
-    struct wl_list outputs;
-    struct wl_listener output_destroyed_listener;
+    struct ww_output_registry outputs;
 };
 
 struct weston_background_output {
-    struct wl_list link;
+    struct weston_background *back;
     struct weston_output *output;
     struct weston_surface *surface;
     struct weston_view *view;
@@ -60,19 +67,6 @@ struct weston_background_output {
     struct wl_listener view_destroy_listener;
 };
 
-static struct weston_background_output *
-_weston_background_find_output(struct weston_background *back, struct weston_output *woutput)
-{
-    struct weston_background_output *output;
-
-    wl_list_for_each(output, &back->outputs, link)
-    {
-        if ( output->output == woutput )
-            return output;
-    }
-    return NULL;
-}
-
 static void
 _weston_background_output_update_transform(struct weston_background_output *self)
 {
@@ -84,16 +78,22 @@ _weston_background_output_update_transform(struct weston_background_output *self
 }
 
 static void
-_weston_background_output_free(struct weston_background_output *self)
+_weston_background_output_clear(struct weston_background_output *self)
 {
+    if ( self->surface == NULL )
+        return;
+
     if ( self->view != NULL )
         weston_view_destroy(self->view);
 
     wl_list_remove(&self->surface_destroy_listener.link);
 
-    wl_list_remove(&self->link);
-
-    free(self);
+    if ( self->surface->committed_private == self )
+    {
+        self->surface->committed = NULL;
+        self->surface->committed_private = NULL;
+    }
+    self->surface = NULL;
 }
 
 static void
@@ -101,7 +101,7 @@ _weston_background_output_surface_destroyed(struct wl_listener *listener, void *
 {
     struct weston_background_output *self = wl_container_of(listener, self, surface_destroy_listener);
 
-    _weston_background_output_free(self);
+    _weston_background_output_clear(self);
 }
 
 static void
@@ -113,15 +113,68 @@ _weston_background_output_view_destroyed(struct wl_listener *listener, void *dat
     self->view = NULL;
 }
 
+static void
+_weston_background_output_update(struct weston_background_output *self, enum ww_quota_status quota)
+{
+    if ( self->view == NULL )
+        return;
+
+    switch ( quota )
+    {
+    case WW_QUOTA_OK:
+        if ( self->view->layer_link.layer == NULL )
+        {
+            weston_layer_entry_insert(&self->back->layer.view_list, &self->view->layer_link);
+            _weston_background_output_update_transform(self);
+        }
+    break;
+    case WW_QUOTA_EXCEEDED:
+        /* Hidden until the client is under quota */
+        if ( self->view->layer_link.layer != NULL )
+        {
+            weston_view_damage_below(self->view);
+            weston_layer_entry_remove(&self->view->layer_link);
+            weston_compositor_schedule_repaint(self->surface->compositor);
+        }
+    break;
+    case WW_QUOTA_REJECTED:
+    break;
+    }
+}
+
+static void
+_weston_background_output_quota_changed(struct weston_surface *surface, enum ww_quota_status quota)
+{
+    /* The surface was unset */
+    if ( surface->committed_private == NULL )
+        return;
+
+    _weston_background_output_update(surface->committed_private, quota);
+}
+
+static void
+_weston_background_output_committed(struct weston_surface *surface, int32_t sx, int32_t sy)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_background_output *self = surface->committed_private;
+
+    _weston_background_output_update(self, ww_quota_account(surface, WW_QUOTA_ROLE_BACKGROUND, self->back->binding, WESTON_BACKGROUND_ERROR_INVALID_BUFFER, _weston_background_output_quota_changed));
+}
+
 static void
 _weston_background_request_destroy(struct wl_client *client, struct wl_resource *resource)
 {
+    WW_TRACE_SCOPE();
+
     wl_resource_destroy(resource);
 }
 
 static void
 _weston_background_set_background(struct wl_client *client, struct wl_resource *resource, struct wl_resource *surface_resource, struct wl_resource *output_resource)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_background *back = wl_resource_get_user_data(resource);
     struct weston_surface *surface = wl_resource_get_user_data(surface_resource);
     struct weston_output *woutput = wl_resource_get_user_data(output_resource);
@@ -129,28 +182,22 @@ _weston_background_set_background(struct wl_client *client, struct wl_resource *
     if ( weston_surface_set_role(surface, "ww_background", resource, ZWW_BACKGROUND_V2_ERROR_ROLE) < 0 )
         return;
 
-    struct weston_background_output *self = _weston_background_find_output(back, woutput);
+    struct weston_background_output *self = ww_output_registry_get(&back->outputs, woutput);
 
     if ( self == NULL )
     {
-        self = zalloc(sizeof(struct weston_background_output));
-        if ( self == NULL )
-        {
-            wl_resource_post_no_memory(surface_resource);
-            return;
-        }
-        self->output = woutput;
-        wl_list_insert(&back->outputs, &self->link);
-        self->surface_destroy_listener.notify = _weston_background_output_surface_destroyed;
-        self->view_destroy_listener.notify = _weston_background_output_view_destroyed;
-    }
-    else
-    {
-        weston_view_destroy(self->view);
-        wl_list_remove(&self->surface_destroy_listener.link);
+        wl_resource_post_no_memory(surface_resource);
+        return;
     }
 
+    /* A surface backs one output at a time, it leaves its previous one */
+    if ( ( surface->committed == _weston_background_output_committed ) && ( surface->committed_private != self ) )
+        _weston_background_output_clear(surface->committed_private);
+    _weston_background_output_clear(self);
+
     self->surface = surface;
+    self->surface->committed = _weston_background_output_committed;
+    self->surface->committed_private = self;
     self->view = weston_view_create(self->surface);
 
     wl_signal_add(&self->surface->destroy_signal, &self->surface_destroy_listener);
@@ -177,6 +224,8 @@ _weston_background_unbind(struct wl_resource *resource)
 static void
 _weston_background_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_background *back = data;
     struct wl_resource *resource;
 
@@ -194,39 +243,90 @@ _weston_background_bind(struct wl_client *client, void *data, uint32_t version,
 }
 
 static void
-_weston_background_output_destroyed(struct wl_listener *listener, void *data)
+_weston_background_output_created(void *data, struct weston_output *output, void *state)
 {
-    struct weston_background *back = wl_container_of(listener, back, output_destroyed_listener);
-    struct weston_output *woutput = data;
-    struct weston_background_output *self = _weston_background_find_output(back, woutput);
+    WW_TRACE_SCOPE();
 
-    if ( self == NULL )
-        return;
+    struct weston_background_output *self = state;
+
+    self->back = data;
+    self->output = output;
+    self->surface_destroy_listener.notify = _weston_background_output_surface_destroyed;
+    self->view_destroy_listener.notify = _weston_background_output_view_destroyed;
+}
+
+static void
+_weston_background_output_moved(void *data, struct weston_output *output, void *state)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_background_output *self = state;
 
-    _weston_background_output_free(self);
+    if ( self->view != NULL )
+        _weston_background_output_update_transform(self);
 }
 
+static void
+_weston_background_output_destroyed(void *data, struct weston_output *output, void *state)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_background_output *self = state;
+
+    _weston_background_output_clear(self);
+}
+
+static const struct ww_output_registry_interface _weston_background_output_interface = {
+    .created = _weston_background_output_created,
+    .moved = _weston_background_output_moved,
+    .destroyed = _weston_background_output_destroyed,
+};
+
+static void
+_weston_background_stats(void *data, struct ww_stats_sink *sink)
+{
+    struct weston_background *back = data;
+    struct weston_background_output *output;
+    int64_t backgrounds = 0;
+    uint32_t i;
+
+    ww_output_registry_for_each(output, i, &back->outputs)
+    {
+        if ( output->surface != NULL )
+            ++backgrounds;
+    }
+
+    ww_stats_counter(sink, "backgrounds", backgrounds);
+}
+
+#ifdef WW_COMBINED_MODULE
+int
+weston_background_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#else /* ! WW_COMBINED_MODULE */
 WW_EXPORT int
 wet_module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#endif /* ! WW_COMBINED_MODULE */
 {
     struct weston_background *back;
 
+    ww_trace_init(compositor);
+    ww_quota_init(compositor);
+
     back = zalloc(sizeof(struct weston_background));
     if ( back == NULL )
         return -1;
 
     back->compositor = compositor;
 
-    wl_list_init(&back->outputs);
-
     if ( wl_global_create(back->compositor->wl_display, &zww_background_v2_interface, 1, back, _weston_background_bind) == NULL)
         return -1;
 
-    back->output_destroyed_listener.notify = _weston_background_output_destroyed;
-    wl_signal_add(&back->compositor->output_destroyed_signal, &back->output_destroyed_listener);
+    ww_output_registry_init(&back->outputs, back->compositor, sizeof(struct weston_background_output), &_weston_background_output_interface, back);
 
     weston_layer_init(&back->layer, back->compositor);
     weston_layer_set_position(&back->layer, WESTON_LAYER_POSITION_BACKGROUND);
 
+    ww_stats_init(compositor, "background", _weston_background_stats, back);
+
     return 0;
 }
@@ -38,22 +38,35 @@
 #include <wayland-server.h>
 #include <compositor.h>
 #include "unstable/dock-manager/dock-manager-unstable-v2-server-protocol.h"
+#include "layout.h"
+#include "weston-wall.h"
+#include "trace.h"
+#include "layer.h"
+#include "stats.h"
+#include "quota.h"
+#include "output-registry.h"
 
 #define MIN(a,b) (((a) < (b)) ? (a) : (b))
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
+/* Not in the wayland-wall protocol yet, zww_dock_v2 has no other error */
+#define WESTON_DOCK_ERROR_INVALID_BUFFER 0
+
 struct weston_dock_manager {
     struct weston_compositor *compositor;
     struct wl_list resource_list;
-    struct weston_layer layer;
-    struct wl_list outputs;
-    struct wl_listener output_destroyed_listener;
+    struct weston_layer *layer;
+    struct ww_output_registry outputs;
 };
 
+/*
+ * The space taken by the docks on each edge is kept up to date as they
+ * commit, so the work area and dock placement do not walk the docks
+ */
 struct weston_dock_manager_output {
-    struct wl_list link;
     struct weston_output *output;
     struct wl_list docks;
+    struct ww_layout_extents extents;
 };
 
 struct weston_dock {
@@ -65,129 +78,118 @@ struct weston_dock {
     struct weston_surface *surface;
     struct weston_view *view;
     struct wl_listener view_destroy_listener;
+    int32_t size;
 };
 
 static void
 _weston_dock_manager_request_destroy(struct wl_client *client, struct wl_resource *resource)
 {
+    WW_TRACE_SCOPE();
+
     wl_resource_destroy(resource);
 }
 
-static struct weston_dock_manager_output *
-_weston_dock_manager_find_output(struct weston_dock_manager *dock_manager, struct weston_output *woutput)
+static enum ww_layout_edge
+_weston_dock_manager_get_edge(enum zww_dock_manager_v2_position position)
 {
-    struct weston_dock_manager_output *self;
-
-    wl_list_for_each(self, &dock_manager->outputs, link)
+    switch ( position )
     {
-        if ( self->output == woutput )
-            return self;
+    case ZWW_DOCK_MANAGER_V2_POSITION_TOP:
+        return WW_LAYOUT_EDGE_TOP;
+    case ZWW_DOCK_MANAGER_V2_POSITION_BOTTOM:
+        return WW_LAYOUT_EDGE_BOTTOM;
+    case ZWW_DOCK_MANAGER_V2_POSITION_LEFT:
+        return WW_LAYOUT_EDGE_LEFT;
+    case ZWW_DOCK_MANAGER_V2_POSITION_RIGHT:
+        return WW_LAYOUT_EDGE_RIGHT;
+    case ZWW_DOCK_MANAGER_V2_POSITION_DEFAULT:
+        assert(0 && "not reached");
     }
 
-    self = zalloc(sizeof(struct weston_dock_manager_output));
-    if ( self == NULL )
-        return NULL;
-    self->output = woutput;
-    wl_list_insert(&dock_manager->outputs, &self->link);
-    wl_list_init(&self->docks);
+    return WW_LAYOUT_EDGE_BOTTOM;
+}
+
+static int32_t *
+_weston_dock_manager_output_get_extent(struct weston_dock_manager_output *self, enum zww_dock_manager_v2_position position)
+{
+    switch ( _weston_dock_manager_get_edge(position) )
+    {
+    case WW_LAYOUT_EDGE_TOP:
+        return &self->extents.top;
+    case WW_LAYOUT_EDGE_BOTTOM:
+        return &self->extents.bottom;
+    case WW_LAYOUT_EDGE_LEFT:
+        return &self->extents.left;
+    case WW_LAYOUT_EDGE_RIGHT:
+        return &self->extents.right;
+    }
 
-    return self;
+    return NULL;
 }
 
 static struct weston_geometry
 _weston_dock_manager_output_get_workarea(struct weston_dock_manager_output *output)
 {
-    struct weston_dock *dock;
-    struct weston_geometry area = {
+    struct weston_geometry geometry = {
         .x = output->output->x,
         .y = output->output->y,
         .width = output->output->width,
         .height = output->output->height,
     };
 
-    wl_list_for_each(dock, &output->docks, link)
-    {
-        switch ( dock->position )
-        {
-        case ZWW_DOCK_MANAGER_V2_POSITION_TOP:
-            area.y += dock->surface->height;
-        case ZWW_DOCK_MANAGER_V2_POSITION_BOTTOM:
-            area.height -= dock->surface->height;
-        break;
-        case ZWW_DOCK_MANAGER_V2_POSITION_LEFT:
-            area.x += dock->surface->width;
-        case ZWW_DOCK_MANAGER_V2_POSITION_RIGHT:
-            area.width -= dock->surface->width;
-        break;
-        case ZWW_DOCK_MANAGER_V2_POSITION_DEFAULT:
-            assert(0 && "not reached");
-        }
-    }
-
-    return area;
+    return ww_layout_workarea(&geometry, &output->extents);
 }
 
 static void
-_weston_dock_manager_output_free(struct weston_dock_manager_output *self)
+_weston_dock_update_size(struct weston_dock *self, int32_t size)
 {
-    wl_list_remove(&self->link);
-
-    free(self);
+    *_weston_dock_manager_output_get_extent(self->output, self->position) += size - self->size;
+    self->size = size;
 }
 
 static void
-_weston_dock_surface_committed(struct weston_surface *surface, int32_t sx, int32_t sy)
+_weston_dock_update(struct weston_dock *self, enum ww_quota_status quota)
 {
-    struct weston_dock *self = surface->committed_private, *dock;
-    int32_t x, y;
+    int32_t x, y, offset;
 
-    if ( weston_view_is_mapped(self->view) )
+    if ( quota == WW_QUOTA_REJECTED )
         return;
 
-    x = self->output->output->x;
-    y = self->output->output->y;
+    /* Its output is gone */
+    if ( ( self->output == NULL ) || ( self->view == NULL ) )
+        return;
 
-    switch ( self->position )
+    /* Hidden, giving its space back, until the client is under quota */
+    if ( quota == WW_QUOTA_EXCEEDED )
     {
-    case ZWW_DOCK_MANAGER_V2_POSITION_BOTTOM:
-        y += self->output->output->height - self->surface->height;
-    case ZWW_DOCK_MANAGER_V2_POSITION_TOP:
-    break;
-    case ZWW_DOCK_MANAGER_V2_POSITION_RIGHT:
-        x += self->output->output->width - self->surface->width;
-    case ZWW_DOCK_MANAGER_V2_POSITION_LEFT:
-    break;
-    case ZWW_DOCK_MANAGER_V2_POSITION_DEFAULT:
-        assert(0 && "not reached");
+        if ( weston_view_is_mapped(self->view) )
+            weston_view_unmap(self->view);
+        _weston_dock_update_size(self, 0);
+        return;
     }
 
-    wl_list_for_each(dock, &self->output->docks, link)
-    {
-        if ( dock == self )
-            continue;
-        if ( dock->position != self->position )
-            continue;
-
-        switch ( dock->position )
-        {
-        case ZWW_DOCK_MANAGER_V2_POSITION_TOP:
-            y += dock->surface->height;
-        break;
-        case ZWW_DOCK_MANAGER_V2_POSITION_BOTTOM:
-            y -= dock->surface->height;
-        break;
-        case ZWW_DOCK_MANAGER_V2_POSITION_LEFT:
-            x += dock->surface->width;
-        break;
-        case ZWW_DOCK_MANAGER_V2_POSITION_RIGHT:
-            x -= dock->surface->width;
-        break;
-        case ZWW_DOCK_MANAGER_V2_POSITION_DEFAULT:
-            assert(0 && "not reached");
-        }
-    }
+    enum ww_layout_edge edge = _weston_dock_manager_get_edge(self->position);
+
+    if ( ( edge == WW_LAYOUT_EDGE_TOP ) || ( edge == WW_LAYOUT_EDGE_BOTTOM ) )
+        _weston_dock_update_size(self, self->surface->height);
+    else
+        _weston_dock_update_size(self, self->surface->width);
+
+    if ( weston_view_is_mapped(self->view) )
+        return;
 
-    weston_layer_entry_insert(&self->dock_manager->layer.view_list, &self->view->layer_link);
+    struct weston_geometry geometry = {
+        .x = self->output->output->x,
+        .y = self->output->output->y,
+        .width = self->output->output->width,
+        .height = self->output->output->height,
+    };
+
+    /* Stack after the other docks on the same edge */
+    offset = *_weston_dock_manager_output_get_extent(self->output, self->position) - self->size;
+    ww_layout_dock_position(&geometry, edge, self->surface->width, self->surface->height, offset, &x, &y);
+
+    weston_layer_entry_insert(&self->dock_manager->layer->view_list, &self->view->layer_link);
     self->view->is_mapped = true;
     weston_view_set_position(self->view, x, y);
     weston_view_update_transform(self->view);
@@ -195,6 +197,26 @@ _weston_dock_surface_committed(struct weston_surface *surface, int32_t sx, int32
     weston_compositor_schedule_repaint(self->surface->compositor);
 }
 
+static void
+_weston_dock_surface_quota_changed(struct weston_surface *surface, enum ww_quota_status quota)
+{
+    /* The dock was destroyed */
+    if ( surface->committed_private == NULL )
+        return;
+
+    _weston_dock_update(surface->committed_private, quota);
+}
+
+static void
+_weston_dock_surface_committed(struct weston_surface *surface, int32_t sx, int32_t sy)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_dock *self = surface->committed_private;
+
+    _weston_dock_update(self, ww_quota_account(surface, WW_QUOTA_ROLE_DOCK, self->resource, WESTON_DOCK_ERROR_INVALID_BUFFER, _weston_dock_surface_quota_changed));
+}
+
 static void
 _weston_dock_view_destroyed(struct wl_listener *listener, void *data)
 {
@@ -209,9 +231,16 @@ _ww_dock_destroy(struct wl_resource *resource)
 {
     struct weston_dock *self = wl_resource_get_user_data(resource);
 
+    /* The view goes away with the surface, which the client may still hold */
     if ( self->view != NULL )
+    {
+        self->surface->committed = NULL;
+        self->surface->committed_private = NULL;
         weston_view_destroy(self->view);
+    }
 
+    if ( self->output != NULL )
+        _weston_dock_update_size(self, 0);
     wl_list_remove(&self->link);
 
     free(self);
@@ -224,6 +253,8 @@ static const struct zww_dock_v2_interface _ww_dock_interface = {
 static void
 _weston_dock_manager_create_dock(struct wl_client *client, struct wl_resource *resource, uint32_t id, struct wl_resource *surface_resource, struct wl_resource *output_resource, enum zww_dock_manager_v2_position position)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_dock_manager *dock_manager = wl_resource_get_user_data(resource);
     struct weston_surface *surface = wl_resource_get_user_data(surface_resource);
     struct weston_output *woutput = NULL;
@@ -239,7 +270,7 @@ _weston_dock_manager_create_dock(struct wl_client *client, struct wl_resource *r
     if ( weston_surface_set_role(surface, "ww_dock", resource, ZWW_DOCK_MANAGER_V2_ERROR_ROLE) < 0 )
         return;
 
-    output = _weston_dock_manager_find_output(dock_manager, woutput);
+    output = ww_output_registry_get(&dock_manager->outputs, woutput);
     if ( output == NULL )
     {
         wl_client_post_no_memory(client);
@@ -299,8 +330,19 @@ static const struct zww_dock_manager_v2_interface weston_dock_manager_implementa
 static void
 _weston_dock_manager_get_output_work_area(void *data, struct weston_output *woutput, struct weston_geometry *area)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_dock_manager *self = data;
-    struct weston_dock_manager_output *output = _weston_dock_manager_find_output(self, woutput);
+    struct weston_dock_manager_output *output = ww_output_registry_get(&self->outputs, woutput);
+
+    if ( output == NULL )
+    {
+        area->x = woutput->x;
+        area->y = woutput->y;
+        area->width = woutput->width;
+        area->height = woutput->height;
+        return;
+    }
 
     *area = _weston_dock_manager_output_get_workarea(output);
 }
@@ -314,6 +356,8 @@ _weston_dock_manager_unbind(struct wl_resource *resource)
 static void
 _weston_dock_manager_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_dock_manager *self = data;
     struct wl_resource *resource;
 
@@ -324,23 +368,75 @@ _weston_dock_manager_bind(struct wl_client *client, void *data, uint32_t version
 }
 
 static void
-_weston_dock_manager_output_destroyed(struct wl_listener *listener, void *data)
+_weston_dock_manager_output_created(void *data, struct weston_output *woutput, void *state)
 {
-    struct weston_dock_manager *dock_manager = wl_container_of(listener, dock_manager, output_destroyed_listener);
-    struct weston_output *woutput = data;
-    struct weston_dock_manager_output *self = _weston_dock_manager_find_output(dock_manager, woutput);
+    WW_TRACE_SCOPE();
 
-    if ( self == NULL )
-        return;
+    struct weston_dock_manager_output *self = state;
+
+    self->output = woutput;
+    wl_list_init(&self->docks);
+}
+
+static void
+_weston_dock_manager_output_destroyed(void *data, struct weston_output *woutput, void *state)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_dock_manager_output *self = state;
+    struct weston_dock *dock, *tmp;
+
+    /* Docks stay alive until their client destroys them, but are hidden */
+    wl_list_for_each_safe(dock, tmp, &self->docks, link)
+    {
+        if ( dock->view != NULL )
+            weston_view_unmap(dock->view);
+        wl_list_remove(&dock->link);
+        wl_list_init(&dock->link);
+        dock->output = NULL;
+        dock->size = 0;
+    }
+}
+
+static const struct ww_output_registry_interface _weston_dock_manager_output_interface = {
+    .created = _weston_dock_manager_output_created,
+    .destroyed = _weston_dock_manager_output_destroyed,
+};
 
-    _weston_dock_manager_output_free(self);
+static void
+_weston_dock_manager_stats(void *data, struct ww_stats_sink *sink)
+{
+    struct weston_dock_manager *self = data;
+    struct weston_dock_manager_output *output;
+    int64_t docks = 0;
+    uint32_t i;
+
+    ww_output_registry_for_each(output, i, &self->outputs)
+    {
+        char name[64];
+        int64_t count = wl_list_length(&output->docks);
+
+        snprintf(name, sizeof(name), "docks.%s", output->output->name);
+        ww_stats_counter(sink, name, count);
+        docks += count;
+    }
+
+    ww_stats_counter(sink, "docks", docks);
 }
 
+#ifdef WW_COMBINED_MODULE
+int
+weston_dock_manager_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#else /* ! WW_COMBINED_MODULE */
 WW_EXPORT int
 wet_module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#endif /* ! WW_COMBINED_MODULE */
 {
     struct weston_dock_manager *self;
 
+    ww_trace_init(compositor);
+    ww_quota_init(compositor);
+
     self = zalloc(sizeof(struct weston_dock_manager));
     if ( self == NULL )
         return -1;
@@ -348,18 +444,19 @@ wet_module_init(struct weston_compositor *compositor, int *argc, char *argv[])
     self->compositor = compositor;
 
     wl_list_init(&self->resource_list);
-    wl_list_init(&self->outputs);
 
     if ( wl_global_create(self->compositor->wl_display, &zww_dock_manager_v2_interface, 1, self, _weston_dock_manager_bind) == NULL)
         return -1;
 
-    self->output_destroyed_listener.notify = _weston_dock_manager_output_destroyed;
-    wl_signal_add(&self->compositor->output_destroyed_signal, &self->output_destroyed_listener);
+    ww_output_registry_init(&self->outputs, self->compositor, sizeof(struct weston_dock_manager_output), &_weston_dock_manager_output_interface, self);
 
-    weston_layer_init(&self->layer, self->compositor);
-    weston_layer_set_position(&self->layer, WESTON_LAYER_POSITION_UI);
+    self->layer = ww_layer_get(self->compositor, WESTON_LAYER_POSITION_UI);
+    if ( self->layer == NULL )
+        return -1;
 
     /* TODO: Add dock area API support */
 
+    ww_stats_init(compositor, "dock-manager", _weston_dock_manager_stats, self);
+
     return 0;
 }
@@ -0,0 +1,684 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/inotify.h>
+
+#include <wayland-server.h>
+#include "launcher-menu-index.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif /* ! MFD_CLOEXEC */
+
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS (1024 + 9)
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#define F_SEAL_WRITE 0x0008
+#endif /* ! F_ADD_SEALS */
+
+/* Changes usually come in bursts (package installs), wait for them to settle */
+#define WESTON_LAUNCHER_MENU_INDEX_UPDATE_DELAY 250
+
+#define WESTON_LAUNCHER_MENU_INDEX_WATCH_MASK (IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+/*
+ * The scan reads that many directory entries at a time, then yields to
+ * the event loop, so it never blocks the compositor for long
+ */
+#define WESTON_LAUNCHER_MENU_INDEX_SCAN_STEP 32
+
+struct weston_launcher_menu_index_directory {
+    char *path;
+    char *prefix;
+    size_t priority;
+};
+
+/* Directories reached twice (through symlinks) are only scanned once */
+struct weston_launcher_menu_index_visited {
+    dev_t dev;
+    ino_t ino;
+};
+
+struct weston_launcher_menu_index {
+    struct wl_event_loop *loop;
+    weston_launcher_menu_index_updated_func_t updated;
+    void *data;
+    int inotify_fd;
+    struct wl_event_source *inotify_source;
+    struct wl_event_source *update_timer;
+    struct wl_event_source *scan_timer;
+    struct {
+        struct wl_array entries;
+        struct wl_array directories;
+        struct wl_array visited;
+        DIR *dir;
+        struct weston_launcher_menu_index_directory current;
+    } scan;
+    int fd;
+    uint32_t size;
+};
+
+struct weston_launcher_menu_index_desktop_entry {
+    char *id;
+    size_t priority;
+    bool hidden;
+    char *name;
+    char *generic_name;
+    char *comment;
+    char *keywords;
+    char *exec;
+    char *icon;
+    uint32_t flags;
+};
+
+static int
+_weston_launcher_menu_index_memfd_create(const char *name)
+{
+    /* The libc wrapper is too recent to rely on */
+    return syscall(SYS_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+}
+
+static char *
+_weston_launcher_menu_index_strjoin(const char *a, size_t a_length, const char *b)
+{
+    size_t b_length = strlen(b);
+    char *s;
+
+    s = malloc(a_length + b_length + 1);
+    if ( s == NULL )
+        return NULL;
+
+    memcpy(s, a, a_length);
+    memcpy(s + a_length, b, b_length + 1);
+
+    return s;
+}
+
+static void
+_weston_launcher_menu_index_desktop_entry_clear(struct weston_launcher_menu_index_desktop_entry *entry)
+{
+    free(entry->id);
+    free(entry->name);
+    free(entry->generic_name);
+    free(entry->comment);
+    free(entry->keywords);
+    free(entry->exec);
+    free(entry->icon);
+}
+
+static void
+_weston_launcher_menu_index_parse_file(struct wl_array *entries, const char *path, char *id, size_t priority)
+{
+    struct weston_launcher_menu_index_desktop_entry entry = { .id = id, .priority = priority };
+    bool in_group = false, application = false;
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t length;
+    FILE *f;
+
+    f = fopen(path, "re");
+    if ( f == NULL )
+    {
+        free(id);
+        return;
+    }
+
+    while ( ( length = getline(&line, &line_size, f) ) != -1 )
+    {
+        while ( ( length > 0 ) && ( ( line[length - 1] == '\n' ) || ( line[length - 1] == '\r' ) ) )
+            line[--length] = '\0';
+
+        if ( ( line[0] == '\0' ) || ( line[0] == '#' ) )
+            continue;
+
+        if ( line[0] == '[' )
+        {
+            if ( in_group )
+                break;
+            in_group = ( strcmp(line, "[Desktop Entry]") == 0 );
+            continue;
+        }
+
+        if ( ! in_group )
+            continue;
+
+        char *value = strchr(line, '=');
+        if ( value == NULL )
+            continue;
+
+        char *key_end = value;
+        while ( ( key_end > line ) && ( key_end[-1] == ' ' ) )
+            --key_end;
+        *key_end = '\0';
+        ++value;
+        while ( *value == ' ' )
+            ++value;
+
+        /* Localised keys are left to the client */
+        if ( strchr(line, '[') != NULL )
+            continue;
+
+        char **field = NULL;
+        if ( strcmp(line, "Type") == 0 )
+            application = ( strcmp(value, "Application") == 0 );
+        else if ( ( strcmp(line, "NoDisplay") == 0 ) || ( strcmp(line, "Hidden") == 0 ) )
+            entry.hidden = entry.hidden || ( strcmp(value, "true") == 0 );
+        else if ( strcmp(line, "Terminal") == 0 )
+        {
+            if ( strcmp(value, "true") == 0 )
+                entry.flags |= WESTON_LAUNCHER_MENU_INDEX_ENTRY_FLAG_TERMINAL;
+        }
+        else if ( strcmp(line, "Name") == 0 )
+            field = &entry.name;
+        else if ( strcmp(line, "GenericName") == 0 )
+            field = &entry.generic_name;
+        else if ( strcmp(line, "Comment") == 0 )
+            field = &entry.comment;
+        else if ( strcmp(line, "Keywords") == 0 )
+            field = &entry.keywords;
+        else if ( strcmp(line, "Exec") == 0 )
+            field = &entry.exec;
+        else if ( strcmp(line, "Icon") == 0 )
+            field = &entry.icon;
+
+        if ( field != NULL )
+        {
+            free(*field);
+            *field = strdup(value);
+        }
+    }
+
+    free(line);
+    fclose(f);
+
+    /* Hidden entries are kept until deduplication, to shadow lower priority ones */
+    if ( ! application )
+        entry.hidden = true;
+
+    struct weston_launcher_menu_index_desktop_entry *new_entry = wl_array_add(entries, sizeof(struct weston_launcher_menu_index_desktop_entry));
+    if ( new_entry == NULL )
+    {
+        _weston_launcher_menu_index_desktop_entry_clear(&entry);
+        return;
+    }
+    *new_entry = entry;
+}
+
+static void
+_weston_launcher_menu_index_scan_push(struct weston_launcher_menu_index *self, char *path, char *prefix, size_t priority)
+{
+    struct weston_launcher_menu_index_directory *directory;
+
+    directory = ( ( path != NULL ) && ( prefix != NULL ) ) ? wl_array_add(&self->scan.directories, sizeof(struct weston_launcher_menu_index_directory)) : NULL;
+    if ( directory == NULL )
+    {
+        free(prefix);
+        free(path);
+        return;
+    }
+
+    directory->path = path;
+    directory->prefix = prefix;
+    directory->priority = priority;
+}
+
+static void
+_weston_launcher_menu_index_scan_close(struct weston_launcher_menu_index *self)
+{
+    if ( self->scan.dir == NULL )
+        return;
+
+    closedir(self->scan.dir);
+    self->scan.dir = NULL;
+    free(self->scan.current.prefix);
+    free(self->scan.current.path);
+}
+
+static bool
+_weston_launcher_menu_index_scan_visit(struct weston_launcher_menu_index *self, const struct stat *st)
+{
+    struct weston_launcher_menu_index_visited *visited;
+
+    wl_array_for_each(visited, &self->scan.visited)
+    {
+        if ( ( visited->dev == st->st_dev ) && ( visited->ino == st->st_ino ) )
+            return false;
+    }
+
+    visited = wl_array_add(&self->scan.visited, sizeof(struct weston_launcher_menu_index_visited));
+    if ( visited == NULL )
+        return false;
+
+    visited->dev = st->st_dev;
+    visited->ino = st->st_ino;
+
+    return true;
+}
+
+static bool
+_weston_launcher_menu_index_scan_open(struct weston_launcher_menu_index *self)
+{
+    struct weston_launcher_menu_index_directory directory;
+    struct stat st;
+
+    while ( self->scan.directories.size > 0 )
+    {
+        self->scan.directories.size -= sizeof(struct weston_launcher_menu_index_directory);
+        directory = *(struct weston_launcher_menu_index_directory *) ( (char *) self->scan.directories.data + self->scan.directories.size );
+
+        if ( ( stat(directory.path, &st) == 0 ) && S_ISDIR(st.st_mode) && _weston_launcher_menu_index_scan_visit(self, &st) )
+            self->scan.dir = opendir(directory.path);
+
+        if ( self->scan.dir == NULL )
+        {
+            free(directory.prefix);
+            free(directory.path);
+            continue;
+        }
+
+        if ( self->inotify_fd >= 0 )
+            inotify_add_watch(self->inotify_fd, directory.path, WESTON_LAUNCHER_MENU_INDEX_WATCH_MASK);
+        self->scan.current = directory;
+        return true;
+    }
+
+    return false;
+}
+
+static void
+_weston_launcher_menu_index_scan_entry(struct weston_launcher_menu_index *self, const char *name)
+{
+    struct weston_launcher_menu_index_directory *current = &self->scan.current;
+    size_t path_length = strlen(current->path), prefix_length = strlen(current->prefix);
+    struct stat st;
+
+    char *dir_path = _weston_launcher_menu_index_strjoin(current->path, path_length, "/");
+    char *file_path = ( dir_path != NULL ) ? _weston_launcher_menu_index_strjoin(dir_path, path_length + 1, name) : NULL;
+    free(dir_path);
+    if ( file_path == NULL )
+        return;
+
+    if ( stat(file_path, &st) < 0 )
+        ;
+    else if ( S_ISDIR(st.st_mode) )
+    {
+        /* Desktop file IDs of sub-directories entries are joined with '-' */
+        char *sub_prefix = _weston_launcher_menu_index_strjoin(current->prefix, prefix_length, name);
+        char *sub_prefix_dash = ( sub_prefix != NULL ) ? _weston_launcher_menu_index_strjoin(sub_prefix, strlen(sub_prefix), "-") : NULL;
+        free(sub_prefix);
+        _weston_launcher_menu_index_scan_push(self, file_path, sub_prefix_dash, current->priority);
+        return;
+    }
+    else if ( S_ISREG(st.st_mode) )
+    {
+        size_t name_length = strlen(name);
+        if ( ( name_length > strlen(".desktop") ) && ( strcmp(name + name_length - strlen(".desktop"), ".desktop") == 0 ) )
+        {
+            char *id = _weston_launcher_menu_index_strjoin(current->prefix, prefix_length, name);
+            if ( id != NULL )
+                _weston_launcher_menu_index_parse_file(&self->scan.entries, file_path, id, current->priority);
+        }
+    }
+
+    free(file_path);
+}
+
+static void
+_weston_launcher_menu_index_scan_clear(struct weston_launcher_menu_index *self)
+{
+    struct weston_launcher_menu_index_desktop_entry *entry;
+    struct weston_launcher_menu_index_directory *directory;
+
+    _weston_launcher_menu_index_scan_close(self);
+
+    wl_array_for_each(directory, &self->scan.directories)
+    {
+        free(directory->prefix);
+        free(directory->path);
+    }
+    wl_array_for_each(entry, &self->scan.entries)
+        _weston_launcher_menu_index_desktop_entry_clear(entry);
+
+    wl_array_release(&self->scan.directories);
+    wl_array_release(&self->scan.entries);
+    wl_array_release(&self->scan.visited);
+    wl_array_init(&self->scan.directories);
+    wl_array_init(&self->scan.entries);
+    wl_array_init(&self->scan.visited);
+}
+
+static int _weston_launcher_menu_index_inotify_event(int fd, uint32_t mask, void *data);
+
+/* A running scan is restarted, the directories may have changed under it */
+static void
+_weston_launcher_menu_index_scan_start(struct weston_launcher_menu_index *self)
+{
+    const char *data_home = getenv("XDG_DATA_HOME");
+    const char *data_dirs = getenv("XDG_DATA_DIRS");
+    size_t priority = 0;
+    char *path = NULL;
+
+    _weston_launcher_menu_index_scan_clear(self);
+
+    /* Watches are re-created from scratch to follow new and removed directories */
+    if ( self->inotify_source != NULL )
+        wl_event_source_remove(self->inotify_source);
+    if ( self->inotify_fd >= 0 )
+        close(self->inotify_fd);
+    self->inotify_source = NULL;
+    self->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if ( self->inotify_fd >= 0 )
+        self->inotify_source = wl_event_loop_add_fd(self->loop, self->inotify_fd, WL_EVENT_READABLE, _weston_launcher_menu_index_inotify_event, self);
+
+    if ( ( data_home != NULL ) && ( data_home[0] != '\0' ) )
+        path = _weston_launcher_menu_index_strjoin(data_home, strlen(data_home), "/applications");
+    else if ( getenv("HOME") != NULL )
+        path = _weston_launcher_menu_index_strjoin(getenv("HOME"), strlen(getenv("HOME")), "/.local/share/applications");
+    if ( path != NULL )
+        _weston_launcher_menu_index_scan_push(self, path, strdup(""), priority++);
+
+    if ( ( data_dirs == NULL ) || ( data_dirs[0] == '\0' ) )
+        data_dirs = "/usr/local/share:/usr/share";
+
+    const char *dir = data_dirs, *end;
+    do
+    {
+        end = strchr(dir, ':');
+        size_t length = ( end != NULL ) ? (size_t) ( end - dir ) : strlen(dir);
+        if ( length > 0 )
+            _weston_launcher_menu_index_scan_push(self, _weston_launcher_menu_index_strjoin(dir, length, "/applications"), strdup(""), priority++);
+        dir = end + 1;
+    } while ( end != NULL );
+
+    wl_event_source_timer_update(self->scan_timer, 1);
+}
+
+static int
+_weston_launcher_menu_index_desktop_entry_compare(const void *a_, const void *b_)
+{
+    const struct weston_launcher_menu_index_desktop_entry *a = a_, *b = b_;
+    int r;
+
+    r = strcmp(a->id, b->id);
+    if ( r != 0 )
+        return r;
+
+    return ( a->priority > b->priority ) - ( a->priority < b->priority );
+}
+
+static uint32_t
+_weston_launcher_menu_index_add_string(struct wl_array *strings, uint32_t base, const char *s)
+{
+    size_t length;
+    char *data;
+    uint32_t offset = base + strings->size;
+
+    if ( s == NULL )
+        return 0;
+
+    length = strlen(s) + 1;
+    data = wl_array_add(strings, length);
+    if ( data == NULL )
+        return 0;
+    memcpy(data, s, length);
+
+    return offset;
+}
+
+static int
+_weston_launcher_menu_index_build(struct wl_array *entries, uint32_t *size)
+{
+    struct weston_launcher_menu_index_desktop_entry *entry, *last = NULL;
+    struct weston_launcher_menu_index_entry *index_entries;
+    struct wl_array strings;
+    size_t n = entries->size / sizeof(struct weston_launcher_menu_index_desktop_entry);
+    uint32_t count = 0, i = 0;
+    int fd = -1;
+
+    qsort(entries->data, n, sizeof(struct weston_launcher_menu_index_desktop_entry), _weston_launcher_menu_index_desktop_entry_compare);
+
+    /* The first entry of an ID wins, even if it is hidden */
+    wl_array_for_each(entry, entries)
+    {
+        bool shadowed = ( ( last != NULL ) && ( strcmp(last->id, entry->id) == 0 ) );
+        if ( ! shadowed )
+            last = entry;
+        if ( shadowed || entry->hidden )
+            entry->hidden = true;
+        else
+            ++count;
+    }
+
+    index_entries = calloc(count, sizeof(struct weston_launcher_menu_index_entry));
+    if ( ( count > 0 ) && ( index_entries == NULL ) )
+        return -1;
+
+    uint32_t base = sizeof(struct weston_launcher_menu_index_header) + count * sizeof(struct weston_launcher_menu_index_entry);
+    wl_array_init(&strings);
+    wl_array_for_each(entry, entries)
+    {
+        if ( entry->hidden )
+            continue;
+
+        struct weston_launcher_menu_index_entry *index_entry = &index_entries[i++];
+        index_entry->id = _weston_launcher_menu_index_add_string(&strings, base, entry->id);
+        index_entry->name = _weston_launcher_menu_index_add_string(&strings, base, entry->name);
+        index_entry->generic_name = _weston_launcher_menu_index_add_string(&strings, base, entry->generic_name);
+        index_entry->comment = _weston_launcher_menu_index_add_string(&strings, base, entry->comment);
+        index_entry->keywords = _weston_launcher_menu_index_add_string(&strings, base, entry->keywords);
+        index_entry->exec = _weston_launcher_menu_index_add_string(&strings, base, entry->exec);
+        index_entry->icon = _weston_launcher_menu_index_add_string(&strings, base, entry->icon);
+        index_entry->flags = entry->flags;
+    }
+
+    struct weston_launcher_menu_index_header header = {
+        .magic = WESTON_LAUNCHER_MENU_INDEX_MAGIC,
+        .version = WESTON_LAUNCHER_MENU_INDEX_VERSION,
+        .size = base + strings.size,
+        .count = count,
+    };
+
+    fd = _weston_launcher_menu_index_memfd_create("weston-launcher-menu-index");
+    if ( fd < 0 )
+        goto error;
+
+    if ( ftruncate(fd, header.size) < 0 )
+        goto error;
+
+    if ( ( pwrite(fd, &header, sizeof(header), 0) != sizeof(header) )
+         || ( pwrite(fd, index_entries, count * sizeof(struct weston_launcher_menu_index_entry), sizeof(header)) != (ssize_t) ( count * sizeof(struct weston_launcher_menu_index_entry) ) )
+         || ( pwrite(fd, strings.data, strings.size, base) != (ssize_t) strings.size ) )
+        goto error;
+
+    /* Clients get a read-only view that can never change under their feet */
+    if ( fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0 )
+        goto error;
+
+    *size = header.size;
+    wl_array_release(&strings);
+    free(index_entries);
+    return fd;
+
+error:
+    if ( fd >= 0 )
+        close(fd);
+    wl_array_release(&strings);
+    free(index_entries);
+    return -1;
+}
+
+static void
+_weston_launcher_menu_index_scan_finish(struct weston_launcher_menu_index *self)
+{
+    uint32_t size;
+    int fd;
+
+    fd = _weston_launcher_menu_index_build(&self->scan.entries, &size);
+    _weston_launcher_menu_index_scan_clear(self);
+
+    if ( fd < 0 )
+        return;
+
+    if ( self->fd >= 0 )
+        close(self->fd);
+    self->fd = fd;
+    self->size = size;
+
+    self->updated(self->data);
+}
+
+static int
+_weston_launcher_menu_index_scan_timeout(void *data)
+{
+    struct weston_launcher_menu_index *self = data;
+    struct dirent *dirent;
+    int i;
+
+    for ( i = 0 ; i < WESTON_LAUNCHER_MENU_INDEX_SCAN_STEP ; )
+    {
+        if ( ( self->scan.dir == NULL ) && ( ! _weston_launcher_menu_index_scan_open(self) ) )
+        {
+            _weston_launcher_menu_index_scan_finish(self);
+            return 0;
+        }
+
+        dirent = readdir(self->scan.dir);
+        if ( dirent == NULL )
+        {
+            _weston_launcher_menu_index_scan_close(self);
+            continue;
+        }
+
+        if ( dirent->d_name[0] == '.' )
+            continue;
+
+        _weston_launcher_menu_index_scan_entry(self, dirent->d_name);
+        ++i;
+    }
+
+    wl_event_source_timer_update(self->scan_timer, 1);
+
+    return 0;
+}
+
+static int
+_weston_launcher_menu_index_update_timeout(void *data)
+{
+    struct weston_launcher_menu_index *self = data;
+
+    _weston_launcher_menu_index_scan_start(self);
+
+    return 0;
+}
+
+static int
+_weston_launcher_menu_index_inotify_event(int fd, uint32_t mask, void *data)
+{
+    struct weston_launcher_menu_index *self = data;
+    char buffer[4096];
+
+    while ( read(fd, buffer, sizeof(buffer)) > 0 )
+        ;
+
+    wl_event_source_timer_update(self->update_timer, WESTON_LAUNCHER_MENU_INDEX_UPDATE_DELAY);
+
+    return 0;
+}
+
+struct weston_launcher_menu_index *
+weston_launcher_menu_index_new(struct wl_event_loop *loop, weston_launcher_menu_index_updated_func_t updated, void *data)
+{
+    struct weston_launcher_menu_index *self;
+
+    self = calloc(1, sizeof(struct weston_launcher_menu_index));
+    if ( self == NULL )
+        return NULL;
+
+    self->loop = loop;
+    self->updated = updated;
+    self->data = data;
+    self->inotify_fd = -1;
+    self->fd = -1;
+
+    wl_array_init(&self->scan.entries);
+    wl_array_init(&self->scan.directories);
+    wl_array_init(&self->scan.visited);
+
+    self->update_timer = wl_event_loop_add_timer(self->loop, _weston_launcher_menu_index_update_timeout, self);
+    self->scan_timer = wl_event_loop_add_timer(self->loop, _weston_launcher_menu_index_scan_timeout, self);
+    if ( ( self->update_timer == NULL ) || ( self->scan_timer == NULL ) )
+    {
+        if ( self->scan_timer != NULL )
+            wl_event_source_remove(self->scan_timer);
+        if ( self->update_timer != NULL )
+            wl_event_source_remove(self->update_timer);
+        free(self);
+        return NULL;
+    }
+
+    /* The index is available once the first scan is done */
+    _weston_launcher_menu_index_scan_start(self);
+
+    return self;
+}
+
+void
+weston_launcher_menu_index_free(struct weston_launcher_menu_index *self)
+{
+    _weston_launcher_menu_index_scan_clear(self);
+    if ( self->inotify_source != NULL )
+        wl_event_source_remove(self->inotify_source);
+    if ( self->inotify_fd >= 0 )
+        close(self->inotify_fd);
+    wl_event_source_remove(self->scan_timer);
+    wl_event_source_remove(self->update_timer);
+    if ( self->fd >= 0 )
+        close(self->fd);
+
+    free(self);
+}
+
+int
+weston_launcher_menu_index_get_fd(struct weston_launcher_menu_index *self, uint32_t *size)
+{
+    *size = self->size;
+    return self->fd;
+}
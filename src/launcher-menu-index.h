@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __WESTON_LAUNCHER_MENU_INDEX_H__
+#define __WESTON_LAUNCHER_MENU_INDEX_H__
+
+#include <stdint.h>
+#include <wayland-server.h>
+
+/*
+ * Index layout, integers in host byte order:
+ *   struct weston_launcher_menu_index_header
+ *   struct weston_launcher_menu_index_entry[count], sorted by desktop file ID
+ *   NUL-terminated strings
+ * String fields are byte offsets from the start of the index,
+ * 0 meaning the key was not set
+ */
+#define WESTON_LAUNCHER_MENU_INDEX_MAGIC 0x58444957 /* "WIDX" */
+#define WESTON_LAUNCHER_MENU_INDEX_VERSION 1
+
+enum weston_launcher_menu_index_entry_flag {
+    WESTON_LAUNCHER_MENU_INDEX_ENTRY_FLAG_TERMINAL = (1 << 0),
+};
+
+struct weston_launcher_menu_index_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t count;
+};
+
+struct weston_launcher_menu_index_entry {
+    uint32_t id;
+    uint32_t name;
+    uint32_t generic_name;
+    uint32_t comment;
+    uint32_t keywords;
+    uint32_t exec;
+    uint32_t icon;
+    uint32_t flags;
+};
+
+struct weston_launcher_menu_index;
+
+typedef void (*weston_launcher_menu_index_updated_func_t)(void *data);
+
+struct weston_launcher_menu_index *weston_launcher_menu_index_new(struct wl_event_loop *loop, weston_launcher_menu_index_updated_func_t updated, void *data);
+void weston_launcher_menu_index_free(struct weston_launcher_menu_index *self);
+int weston_launcher_menu_index_get_fd(struct weston_launcher_menu_index *self, uint32_t *size);
+
+#endif /* __WESTON_LAUNCHER_MENU_INDEX_H__ */
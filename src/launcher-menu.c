@@ -37,34 +37,62 @@
 
 #include <wayland-server.h>
 #include <compositor.h>
+#include <weston.h>
 #include "unstable/launcher-menu/launcher-menu-unstable-v1-server-protocol.h"
+#include "launcher-menu-index.h"
+#include "layout.h"
+#include "weston-wall.h"
+#include "trace.h"
+#include "layer.h"
+#include "stats.h"
+#include "quota.h"
 
 #define MIN(a,b) (((a) < (b)) ? (a) : (b))
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
-enum weston_launcher_menu_positon {
-    WESTON_LAUNCHER_MENU_POSITION_DEFAULT,
-    WESTON_LAUNCHER_MENU_POSITION_POINTER,
-    WESTON_LAUNCHER_MENU_POSITION_SURFACE,
+#define WESTON_LAUNCHER_MENU_VERSION 2
+
+enum weston_launcher_menu_edge {
+    WESTON_LAUNCHER_MENU_EDGE_NONE = 0,
+    WESTON_LAUNCHER_MENU_EDGE_TOP = (1 << 0),
+    WESTON_LAUNCHER_MENU_EDGE_BOTTOM = (1 << 1),
+    WESTON_LAUNCHER_MENU_EDGE_LEFT = (1 << 2),
+    WESTON_LAUNCHER_MENU_EDGE_RIGHT = (1 << 3),
+};
+
+enum weston_launcher_menu_constraint {
+    WESTON_LAUNCHER_MENU_CONSTRAINT_NONE = 0,
+    WESTON_LAUNCHER_MENU_CONSTRAINT_FLIP_X = (1 << 0),
+    WESTON_LAUNCHER_MENU_CONSTRAINT_FLIP_Y = (1 << 1),
+    WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_X = (1 << 2),
+    WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_Y = (1 << 3),
+};
+
+/*
+ * Similar to xdg_positioner: the menu is placed relative to the anchor
+ * point of anchor_rect, extending toward gravity, and is kept inside
+ * the output using the allowed constraint adjustments
+ */
+struct weston_launcher_menu_positioner {
+    struct weston_geometry anchor_rect;
+    uint32_t anchor;
+    uint32_t gravity;
+    uint32_t constraints;
 };
 
 struct weston_launcher_menu {
     struct weston_compositor *compositor;
     struct wl_resource *binding;
-    struct weston_layer layer;
+    struct weston_layer *layer;
     struct wl_list seats;
     struct wl_listener output_destroyed_listener;
-    struct weston_output *output;
-    struct weston_surface *surface;
-    struct weston_view *view;
-    struct wl_listener surface_destroy_listener;
-    struct wl_listener view_destroy_listener;
-    struct weston_launcher_menu_seat *grab_seat;
-    enum weston_launcher_menu_positon position;
+    bool coalesce_motion;
+    struct weston_launcher_menu_index *index;
     struct {
-        struct weston_view *view;
-        struct weston_geometry geometry;
-    } target;
+        int64_t grabs_started;
+        int64_t grabs_dismissed;
+        struct ww_stats_histogram map_latency;
+    } stats;
 };
 
 struct weston_launcher_menu_seat {
@@ -72,12 +100,54 @@ struct weston_launcher_menu_seat {
     struct weston_launcher_menu *launcher_menu;
     struct weston_seat *seat;
     struct wl_listener seat_destroy_listener;
+    struct weston_output *output;
+    struct weston_surface *surface;
+    struct weston_view *view;
+    struct wl_listener surface_destroy_listener;
+    struct wl_listener view_destroy_listener;
+    struct weston_launcher_menu_positioner positioner;
     struct {
         struct weston_keyboard_grab keyboard;
         struct weston_pointer_grab pointer;
         struct weston_touch_grab touch;
         bool initial_up;
+        struct wl_array pending_keys;
+        uint64_t show_time;
+        bool over_quota;
     } grab;
+    struct {
+        struct weston_output *output;
+        struct wl_listener frame_listener;
+        uint32_t time;
+        uint32_t mask;
+        double dx;
+        double dy;
+        double dx_unaccel;
+        double dy_unaccel;
+    } motion;
+};
+
+enum weston_launcher_menu_key_event_type {
+    WESTON_LAUNCHER_MENU_KEY_EVENT_KEY,
+    WESTON_LAUNCHER_MENU_KEY_EVENT_MODIFIERS,
+};
+
+struct weston_launcher_menu_key_event {
+    enum weston_launcher_menu_key_event_type type;
+    union {
+        struct {
+            uint32_t time;
+            uint32_t key;
+            enum wl_keyboard_key_state state;
+        } key;
+        struct {
+            uint32_t serial;
+            uint32_t mods_depressed;
+            uint32_t mods_latched;
+            uint32_t mods_locked;
+            uint32_t group;
+        } modifiers;
+    };
 };
 
 static struct weston_output *
@@ -104,23 +174,98 @@ _weston_launcher_menu_get_default_seat(struct weston_launcher_menu *self)
 
 static void _weston_launcher_menu_seat_grab_end(struct weston_launcher_menu_seat *self, bool dismiss);
 
+/*
+ * Until the menu surface got its first content, key events are kept in
+ * order and replayed on map, so that type-ahead is not lost
+ */
+static bool
+_weston_launcher_menu_seat_buffer_keys(struct weston_launcher_menu_seat *self)
+{
+    return ( self->view != NULL ) && ( ! weston_view_is_mapped(self->view) );
+}
+
+static void
+_weston_launcher_menu_seat_replay_keys(struct weston_launcher_menu_seat *self)
+{
+    struct weston_keyboard *keyboard = weston_seat_get_keyboard(self->seat);
+    struct weston_launcher_menu_key_event *event;
+
+    if ( keyboard != NULL )
+    {
+        wl_array_for_each(event, &self->grab.pending_keys)
+        {
+            switch ( event->type )
+            {
+            case WESTON_LAUNCHER_MENU_KEY_EVENT_KEY:
+                weston_keyboard_send_key(keyboard, event->key.time, event->key.key, event->key.state);
+            break;
+            case WESTON_LAUNCHER_MENU_KEY_EVENT_MODIFIERS:
+                weston_keyboard_send_modifiers(keyboard, event->modifiers.serial, event->modifiers.mods_depressed, event->modifiers.mods_latched, event->modifiers.mods_locked, event->modifiers.group);
+            break;
+            }
+        }
+    }
+
+    self->grab.pending_keys.size = 0;
+}
+
 static void
 _weston_launcher_menu_seat_grab_keyboard_key(struct weston_keyboard_grab *grab,
                         uint32_t time, uint32_t key,
                         enum wl_keyboard_key_state state)
 {
-    weston_keyboard_send_key(grab->keyboard, time, key, state);
+    WW_TRACE_SCOPE();
+
+    struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.keyboard);
+    struct weston_launcher_menu_key_event *event;
+
+    if ( ! _weston_launcher_menu_seat_buffer_keys(self) )
+    {
+        weston_keyboard_send_key(grab->keyboard, time, key, state);
+        return;
+    }
+
+    event = wl_array_add(&self->grab.pending_keys, sizeof(struct weston_launcher_menu_key_event));
+    if ( event == NULL )
+        return;
+
+    event->type = WESTON_LAUNCHER_MENU_KEY_EVENT_KEY;
+    event->key.time = time;
+    event->key.key = key;
+    event->key.state = state;
 }
 
 static void
 _weston_launcher_menu_seat_grab_keyboard_modifiers(struct weston_keyboard_grab *grab, uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group)
 {
-    weston_keyboard_send_modifiers(grab->keyboard, serial, mods_depressed, mods_latched, mods_locked, group);
+    WW_TRACE_SCOPE();
+
+    struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.keyboard);
+    struct weston_launcher_menu_key_event *event;
+
+    if ( ! _weston_launcher_menu_seat_buffer_keys(self) )
+    {
+        weston_keyboard_send_modifiers(grab->keyboard, serial, mods_depressed, mods_latched, mods_locked, group);
+        return;
+    }
+
+    event = wl_array_add(&self->grab.pending_keys, sizeof(struct weston_launcher_menu_key_event));
+    if ( event == NULL )
+        return;
+
+    event->type = WESTON_LAUNCHER_MENU_KEY_EVENT_MODIFIERS;
+    event->modifiers.serial = serial;
+    event->modifiers.mods_depressed = mods_depressed;
+    event->modifiers.mods_latched = mods_latched;
+    event->modifiers.mods_locked = mods_locked;
+    event->modifiers.group = group;
 }
 
 static void
 _weston_launcher_menu_seat_grab_keyboard_cancel(struct weston_keyboard_grab *grab)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.keyboard);
 
     _weston_launcher_menu_seat_grab_end(self, true);
@@ -135,6 +280,8 @@ static const struct weston_keyboard_grab_interface _weston_desktop_seat_grab_key
 static void
 _weston_launcher_menu_seat_grab_pointer_focus(struct weston_pointer_grab *grab)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.pointer);
     struct weston_pointer *pointer = grab->pointer;
     struct weston_view *view;
@@ -142,25 +289,115 @@ _weston_launcher_menu_seat_grab_pointer_focus(struct weston_pointer_grab *grab)
 
     view = weston_compositor_pick_view(pointer->seat->compositor, pointer->x, pointer->y, &sx, &sy);
 
-    if ( ( view != NULL ) && ( view->surface->resource != NULL ) && ( view == self->launcher_menu->view ) )
+    if ( ( view != NULL ) && ( view->surface->resource != NULL ) && ( view == self->view ) )
         weston_pointer_set_focus(pointer, view, sx, sy);
     else
         weston_pointer_clear_focus(pointer);
 }
 
+/*
+ * In coalescing mode, the pointer is moved right away but the client only
+ * gets the latest position, with the accumulated relative motion, once
+ * per output repaint
+ */
+static void
+_weston_launcher_menu_seat_motion_cancel(struct weston_launcher_menu_seat *self)
+{
+    if ( self->motion.output == NULL )
+        return;
+
+    wl_list_remove(&self->motion.frame_listener.link);
+    self->motion.output = NULL;
+}
+
+static void
+_weston_launcher_menu_seat_motion_flush(struct weston_launcher_menu_seat *self)
+{
+    struct weston_pointer *pointer = weston_seat_get_pointer(self->seat);
+
+    if ( self->motion.output == NULL )
+        return;
+
+    _weston_launcher_menu_seat_motion_cancel(self);
+
+    if ( pointer == NULL )
+        return;
+
+    struct weston_pointer_motion_event event = {
+        .mask = WESTON_POINTER_MOTION_ABS | self->motion.mask,
+        .x = wl_fixed_to_double(pointer->x),
+        .y = wl_fixed_to_double(pointer->y),
+        .dx = self->motion.dx,
+        .dy = self->motion.dy,
+        .dx_unaccel = self->motion.dx_unaccel,
+        .dy_unaccel = self->motion.dy_unaccel,
+    };
+
+    weston_pointer_send_motion(pointer, self->motion.time, &event);
+    weston_pointer_send_frame(pointer);
+}
+
+static void
+_weston_launcher_menu_seat_motion_output_frame(struct wl_listener *listener, void *data)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_launcher_menu_seat *self = wl_container_of(listener, self, motion.frame_listener);
+
+    _weston_launcher_menu_seat_motion_flush(self);
+}
+
 static void
 _weston_launcher_menu_seat_grab_pointer_motion(struct weston_pointer_grab *grab, uint32_t time, struct weston_pointer_motion_event *event)
 {
-    weston_pointer_send_motion(grab->pointer, time, event);
+    WW_TRACE_SCOPE();
+
+    struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.pointer);
+
+    if ( ( ! self->launcher_menu->coalesce_motion ) || ( self->output == NULL ) )
+    {
+        weston_pointer_send_motion(grab->pointer, time, event);
+        return;
+    }
+
+    weston_pointer_move(grab->pointer, event);
+
+    if ( self->motion.output == NULL )
+    {
+        self->motion.output = self->output;
+        self->motion.mask = 0;
+        self->motion.dx = self->motion.dy = 0;
+        self->motion.dx_unaccel = self->motion.dy_unaccel = 0;
+        wl_signal_add(&self->motion.output->frame_signal, &self->motion.frame_listener);
+        weston_output_schedule_repaint(self->motion.output);
+    }
+
+    self->motion.time = time;
+    if ( event->mask & WESTON_POINTER_MOTION_REL )
+    {
+        self->motion.mask |= WESTON_POINTER_MOTION_REL;
+        self->motion.dx += event->dx;
+        self->motion.dy += event->dy;
+    }
+    if ( event->mask & WESTON_POINTER_MOTION_REL_UNACCEL )
+    {
+        self->motion.mask |= WESTON_POINTER_MOTION_REL_UNACCEL;
+        self->motion.dx_unaccel += event->dx_unaccel;
+        self->motion.dy_unaccel += event->dy_unaccel;
+    }
 }
 
 static void
 _weston_launcher_menu_seat_grab_pointer_button(struct weston_pointer_grab *grab, uint32_t time, uint32_t button, enum wl_pointer_button_state state)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.pointer);
     struct weston_pointer *pointer = grab->pointer;
     bool initial_up = self->grab.initial_up;
 
+    _weston_launcher_menu_seat_motion_flush(self);
+
     if ( state == WL_POINTER_BUTTON_STATE_RELEASED )
         self->grab.initial_up = true;
 
@@ -173,24 +410,40 @@ _weston_launcher_menu_seat_grab_pointer_button(struct weston_pointer_grab *grab,
 static void
 _weston_launcher_menu_seat_grab_pointer_axis(struct weston_pointer_grab *grab, uint32_t time, struct weston_pointer_axis_event *event)
 {
+    WW_TRACE_SCOPE();
+
+    struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.pointer);
+
+    _weston_launcher_menu_seat_motion_flush(self);
     weston_pointer_send_axis(grab->pointer, time, event);
 }
 
 static void
 _weston_launcher_menu_seat_grab_pointer_axis_source(struct weston_pointer_grab *grab, uint32_t source)
 {
+    struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.pointer);
+
+    _weston_launcher_menu_seat_motion_flush(self);
     weston_pointer_send_axis_source(grab->pointer, source);
 }
 
 static void
 _weston_launcher_menu_seat_grab_pointer_frame(struct weston_pointer_grab *grab)
 {
+    struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.pointer);
+
+    /* The flush will send its own frame */
+    if ( self->motion.output != NULL )
+        return;
+
     weston_pointer_send_frame(grab->pointer);
 }
 
 static void
 _weston_launcher_menu_seat_grab_pointer_cancel(struct weston_pointer_grab *grab)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.pointer);
 
     _weston_launcher_menu_seat_grab_end(self, true);
@@ -209,18 +462,24 @@ static const struct weston_pointer_grab_interface _weston_desktop_seat_grab_poin
 static void
 _weston_launcher_menu_seat_grab_touch_down(struct weston_touch_grab *grab, uint32_t time, int touch_id, wl_fixed_t sx, wl_fixed_t sy)
 {
+    WW_TRACE_SCOPE();
+
     weston_touch_send_down(grab->touch, time, touch_id, sx, sy);
 }
 
 static void
 _weston_launcher_menu_seat_grab_touch_up(struct weston_touch_grab *grab, uint32_t time, int touch_id)
 {
+    WW_TRACE_SCOPE();
+
     weston_touch_send_up(grab->touch, time, touch_id);
 }
 
 static void
 _weston_launcher_menu_seat_grab_touch_motion(struct weston_touch_grab *grab, uint32_t time, int touch_id, wl_fixed_t sx, wl_fixed_t sy)
 {
+    WW_TRACE_SCOPE();
+
     weston_touch_send_motion(grab->touch, time, touch_id, sx, sy);
 }
 
@@ -233,6 +492,8 @@ _weston_launcher_menu_seat_grab_touch_frame(struct weston_touch_grab *grab)
 static void
 _weston_launcher_menu_seat_grab_touch_cancel(struct weston_touch_grab *grab)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_launcher_menu_seat *self = wl_container_of(grab, self, grab.touch);
 
     _weston_launcher_menu_seat_grab_end(self, true);
@@ -255,31 +516,29 @@ _weston_launcher_menu_seat_grab_start(struct weston_launcher_menu_seat *self)
 
     if ( ( keyboard != NULL ) && ( keyboard->grab->interface != &_weston_desktop_seat_grab_keyboard_interface ) )
     {
-        weston_keyboard_set_focus(keyboard, self->launcher_menu->surface);
+        weston_keyboard_set_focus(keyboard, self->surface);
         weston_keyboard_start_grab(keyboard, &self->grab.keyboard);
     }
 
     if ( ( pointer != NULL ) && ( pointer->grab->interface != &_weston_desktop_seat_grab_pointer_interface ) )
     {
-        weston_pointer_set_focus(pointer, self->launcher_menu->view, 0, 0);
+        weston_pointer_set_focus(pointer, self->view, 0, 0);
         weston_pointer_start_grab(pointer, &self->grab.pointer);
     }
 
     if ( ( touch != NULL ) && ( touch->grab->interface != &_weston_desktop_seat_grab_touch_interface ) )
     {
-        weston_touch_set_focus(touch, self->launcher_menu->view);
+        weston_touch_set_focus(touch, self->view);
         weston_touch_start_grab(touch, &self->grab.touch);
     }
 
     self->grab.initial_up = ( ( pointer == NULL ) || ( pointer->button_count == 0 ) );
+    ww_stats_add(&self->launcher_menu->stats.grabs_started, 1);
 }
 
 static void
 _weston_launcher_menu_seat_grab_end(struct weston_launcher_menu_seat *self, bool dismiss)
 {
-    if ( self == NULL )
-        return;
-
     struct weston_keyboard *keyboard = weston_seat_get_keyboard(self->seat);
     struct weston_pointer *pointer = weston_seat_get_pointer(self->seat);
     struct weston_touch *touch = weston_seat_get_touch(self->seat);
@@ -293,9 +552,14 @@ _weston_launcher_menu_seat_grab_end(struct weston_launcher_menu_seat *self, bool
     if ((touch != NULL) && (touch->grab->interface == &_weston_desktop_seat_grab_touch_interface))
         weston_touch_end_grab(touch);
 
+    self->grab.pending_keys.size = 0;
+    _weston_launcher_menu_seat_motion_cancel(self);
+
+    if ( dismiss )
+        ww_stats_add(&self->launcher_menu->stats.grabs_dismissed, 1);
+
     if ( dismiss && ( self->launcher_menu->binding != NULL ) )
         zww_launcher_menu_v1_send_dismiss(self->launcher_menu->binding);
-    self->launcher_menu->grab_seat = NULL;
 }
 
 static void
@@ -303,6 +567,23 @@ _weston_launcher_menu_seat_destroy(struct wl_listener *listener, void *data)
 {
     struct weston_launcher_menu_seat *self = wl_container_of(listener, self, seat_destroy_listener);
 
+    if ( self->surface != NULL )
+    {
+        _weston_launcher_menu_seat_grab_end(self, true);
+        self->surface->committed = NULL;
+        self->surface->committed_private = NULL;
+        wl_list_remove(&self->surface_destroy_listener.link);
+    }
+    if ( self->view != NULL )
+    {
+        wl_list_remove(&self->view_destroy_listener.link);
+        weston_view_destroy(self->view);
+    }
+
+    wl_list_remove(&self->seat_destroy_listener.link);
+    wl_list_remove(&self->link);
+    wl_array_release(&self->grab.pending_keys);
+
     free(self);
 }
 
@@ -325,60 +606,188 @@ _weston_launcher_menu_seat_from_seat(struct weston_seat *seat, struct weston_lau
 
     self->seat_destroy_listener.notify = _weston_launcher_menu_seat_destroy;
     wl_signal_add(&seat->destroy_signal, &self->seat_destroy_listener);
+    wl_list_insert(&launcher_menu->seats, &self->link);
 
     self->grab.keyboard.interface = &_weston_desktop_seat_grab_keyboard_interface;
     self->grab.pointer.interface = &_weston_desktop_seat_grab_pointer_interface;
     self->grab.touch.interface = &_weston_desktop_seat_grab_touch_interface;
+    wl_array_init(&self->grab.pending_keys);
+    self->motion.frame_listener.notify = _weston_launcher_menu_seat_motion_output_frame;
 
     return self;
 }
 
 
-static void
-_weston_launcher_menu_surface_update_position(struct weston_launcher_menu *self)
+static struct weston_output *
+_weston_launcher_menu_get_output_at(struct weston_launcher_menu *self, int32_t x, int32_t y)
 {
-    int x = 0, y = 0;
-    switch ( self->position )
-    {
-    case WESTON_LAUNCHER_MENU_POSITION_DEFAULT:
+    struct weston_output *output;
+
+    wl_list_for_each(output, &self->compositor->output_list, link)
     {
-        struct weston_output *output = self->output;
-        x = output->x + ( output->width / 2 - self->surface->width / 2 );
-        y = output->y + ( output->height / 2 - self->surface->height / 2 );
+        if ( ( x >= output->x ) && ( y >= output->y ) && ( x < output->x + output->width ) && ( y < output->y + output->height ) )
+            return output;
     }
-    break;
-    case WESTON_LAUNCHER_MENU_POSITION_POINTER:
-    {
-        struct weston_pointer *pointer = weston_seat_get_pointer(self->grab_seat->seat);
 
-        x = wl_fixed_to_int(pointer->x);
-        y = wl_fixed_to_int(pointer->y);
-    }
-    break;
-    case WESTON_LAUNCHER_MENU_POSITION_SURFACE:
+    return NULL;
+}
+
+static void
+_weston_launcher_menu_positioner_get_position(const struct weston_launcher_menu_positioner *self, int32_t width, int32_t height, const struct weston_geometry *bounds, int32_t *x, int32_t *y)
+{
+    *x = ww_layout_positioner_solve_axis(self->anchor_rect.x, self->anchor_rect.width,
+        self->anchor & WESTON_LAUNCHER_MENU_EDGE_LEFT, self->anchor & WESTON_LAUNCHER_MENU_EDGE_RIGHT,
+        self->gravity & WESTON_LAUNCHER_MENU_EDGE_LEFT, self->gravity & WESTON_LAUNCHER_MENU_EDGE_RIGHT,
+        self->constraints & WESTON_LAUNCHER_MENU_CONSTRAINT_FLIP_X, self->constraints & WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_X,
+        width, bounds->x, bounds->width);
+    *y = ww_layout_positioner_solve_axis(self->anchor_rect.y, self->anchor_rect.height,
+        self->anchor & WESTON_LAUNCHER_MENU_EDGE_TOP, self->anchor & WESTON_LAUNCHER_MENU_EDGE_BOTTOM,
+        self->gravity & WESTON_LAUNCHER_MENU_EDGE_TOP, self->gravity & WESTON_LAUNCHER_MENU_EDGE_BOTTOM,
+        self->constraints & WESTON_LAUNCHER_MENU_CONSTRAINT_FLIP_Y, self->constraints & WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_Y,
+        height, bounds->y, bounds->height);
+}
+
+static void
+_weston_launcher_menu_positioner_get_available_size(const struct weston_launcher_menu_positioner *self, const struct weston_geometry *bounds, int32_t *width, int32_t *height)
+{
+    *width = ww_layout_positioner_available_axis(self->anchor_rect.x, self->anchor_rect.width,
+        self->anchor & WESTON_LAUNCHER_MENU_EDGE_LEFT, self->anchor & WESTON_LAUNCHER_MENU_EDGE_RIGHT,
+        self->gravity & WESTON_LAUNCHER_MENU_EDGE_LEFT, self->gravity & WESTON_LAUNCHER_MENU_EDGE_RIGHT,
+        self->constraints & WESTON_LAUNCHER_MENU_CONSTRAINT_FLIP_X, self->constraints & WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_X,
+        bounds->x, bounds->width);
+    *height = ww_layout_positioner_available_axis(self->anchor_rect.y, self->anchor_rect.height,
+        self->anchor & WESTON_LAUNCHER_MENU_EDGE_TOP, self->anchor & WESTON_LAUNCHER_MENU_EDGE_BOTTOM,
+        self->gravity & WESTON_LAUNCHER_MENU_EDGE_TOP, self->gravity & WESTON_LAUNCHER_MENU_EDGE_BOTTOM,
+        self->constraints & WESTON_LAUNCHER_MENU_CONSTRAINT_FLIP_Y, self->constraints & WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_Y,
+        bounds->y, bounds->height);
+}
+
+static void
+_weston_launcher_menu_seat_set_positioner(struct weston_launcher_menu_seat *self, const struct weston_launcher_menu_positioner *positioner)
+{
+    struct weston_output *output;
+
+    self->positioner = *positioner;
+
+    output = _weston_launcher_menu_get_output_at(self->launcher_menu, positioner->anchor_rect.x + positioner->anchor_rect.width / 2, positioner->anchor_rect.y + positioner->anchor_rect.height / 2);
+    if ( output != NULL )
+        self->output = output;
+
+    if ( ( self->output != NULL ) && ( wl_resource_get_version(self->launcher_menu->binding) >= ZWW_LAUNCHER_MENU_V1_CONFIGURE_SINCE_VERSION ) )
     {
-        x = self->target.view->geometry.x + self->target.geometry.x;
-        y = self->target.view->geometry.y + self->target.geometry.y + self->target.geometry.height;
+        struct weston_geometry bounds = {
+            .x = self->output->x,
+            .y = self->output->y,
+            .width = self->output->width,
+            .height = self->output->height,
+        };
+        int32_t width, height;
+
+        _weston_launcher_menu_positioner_get_available_size(&self->positioner, &bounds, &width, &height);
+        zww_launcher_menu_v1_send_configure(self->launcher_menu->binding, width, height);
     }
-    break;
+}
+
+static void
+_weston_launcher_menu_seat_set_default_positioner(struct weston_launcher_menu_seat *self)
+{
+    struct weston_launcher_menu_positioner positioner = {
+        .anchor = WESTON_LAUNCHER_MENU_EDGE_NONE,
+        .gravity = WESTON_LAUNCHER_MENU_EDGE_NONE,
+        .constraints = WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_X | WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_Y,
+    };
+
+    if ( self->output != NULL )
+    {
+        positioner.anchor_rect.x = self->output->x;
+        positioner.anchor_rect.y = self->output->y;
+        positioner.anchor_rect.width = self->output->width;
+        positioner.anchor_rect.height = self->output->height;
     }
 
+    _weston_launcher_menu_seat_set_positioner(self, &positioner);
+}
+
+static void
+_weston_launcher_menu_surface_update_position(struct weston_launcher_menu_seat *self)
+{
+    struct weston_geometry bounds;
+    int32_t x, y;
+
+    if ( self->output == NULL )
+        return;
+
+    bounds.x = self->output->x;
+    bounds.y = self->output->y;
+    bounds.width = self->output->width;
+    bounds.height = self->output->height;
+
+    _weston_launcher_menu_positioner_get_position(&self->positioner, self->surface->width, self->surface->height, &bounds, &x, &y);
+
     weston_view_set_position(self->view, x, y);
 
     weston_surface_damage(self->surface);
     weston_compositor_schedule_repaint(self->surface->compositor);
 }
 
+static void
+_weston_launcher_menu_surface_hide(struct weston_launcher_menu_seat *self)
+{
+    /* Hide it and do not leave an invisible grab behind */
+    if ( ! self->grab.over_quota )
+    {
+        if ( weston_view_is_mapped(self->view) )
+            weston_view_unmap(self->view);
+        _weston_launcher_menu_seat_grab_end(self, true);
+    }
+    self->grab.over_quota = true;
+}
+
+static void
+_weston_launcher_menu_surface_quota_changed(struct weston_surface *surface, enum ww_quota_status quota)
+{
+    struct weston_launcher_menu_seat *self = surface->committed_private;
+
+    /* The seat is gone */
+    if ( self == NULL )
+        return;
+
+    /* The menu was dismissed, the client maps it again with its next commit */
+    if ( quota == WW_QUOTA_EXCEEDED )
+        _weston_launcher_menu_surface_hide(self);
+    else
+        self->grab.over_quota = false;
+}
+
 static void
 _weston_launcher_menu_surface_committed(struct weston_surface *surface, int32_t sx, int32_t sy)
 {
-    struct weston_launcher_menu *self = surface->committed_private;
+    WW_TRACE_SCOPE();
+
+    struct weston_launcher_menu_seat *self = surface->committed_private;
+
+    switch ( ww_quota_account(surface, WW_QUOTA_ROLE_LAUNCHER_MENU, self->launcher_menu->binding, ZWW_LAUNCHER_MENU_V1_ERROR_INVALID_BUFFER, _weston_launcher_menu_surface_quota_changed) )
+    {
+    case WW_QUOTA_OK:
+        self->grab.over_quota = false;
+    break;
+    case WW_QUOTA_EXCEEDED:
+        _weston_launcher_menu_surface_hide(self);
+        return;
+    case WW_QUOTA_REJECTED:
+        return;
+    }
 
     if ( ! weston_view_is_mapped(self->view) )
     {
         self->surface->is_mapped = true;
         self->view->is_mapped = true;
-        weston_layer_entry_insert(&self->layer.view_list, &self->view->layer_link);
+        weston_layer_entry_insert(&self->launcher_menu->layer->view_list, &self->view->layer_link);
+
+        ww_stats_stop(&self->launcher_menu->stats.map_latency, self->grab.show_time);
+        self->grab.show_time = 0;
+
+        _weston_launcher_menu_seat_replay_keys(self);
     }
 
     _weston_launcher_menu_surface_update_position(self);
@@ -387,18 +796,20 @@ _weston_launcher_menu_surface_committed(struct weston_surface *surface, int32_t
 static void
 _weston_launcher_menu_surface_destroyed(struct wl_listener *listener, void *data)
 {
-    struct weston_launcher_menu *self = wl_container_of(listener, self, surface_destroy_listener);
+    struct weston_launcher_menu_seat *self = wl_container_of(listener, self, surface_destroy_listener);
 
-    self->surface = NULL;
+    wl_list_remove(&self->surface_destroy_listener.link);
+    _weston_launcher_menu_seat_grab_end(self, false);
 
-    _weston_launcher_menu_seat_grab_end(self->grab_seat, false);
+    self->surface = NULL;
 }
 
 static void
 _weston_launcher_menu_view_destroyed(struct wl_listener *listener, void *data)
 {
-    struct weston_launcher_menu *self = wl_container_of(listener, self, view_destroy_listener);
+    struct weston_launcher_menu_seat *self = wl_container_of(listener, self, view_destroy_listener);
 
+    wl_list_remove(&self->view_destroy_listener.link);
     weston_view_damage_below(self->view);
     self->view = NULL;
 }
@@ -406,30 +817,40 @@ _weston_launcher_menu_view_destroyed(struct wl_listener *listener, void *data)
 static void
 _weston_launcher_menu_request_destroy(struct wl_client *client, struct wl_resource *resource)
 {
+    WW_TRACE_SCOPE();
+
     wl_resource_destroy(resource);
 }
 
-static void
-_weston_launcher_menu_show_common(struct weston_launcher_menu *self, struct wl_client *client, struct weston_surface *surface, struct weston_seat *grab_seat)
+static struct weston_launcher_menu_seat *
+_weston_launcher_menu_show_common(struct weston_launcher_menu *launcher_menu, struct wl_client *client, struct weston_surface *surface, struct weston_seat *grab_seat)
 {
     struct weston_keyboard *keyboard = weston_seat_get_keyboard(grab_seat);
+    struct weston_launcher_menu_seat *self;
 
-    if ( self->surface != NULL )
+    self = _weston_launcher_menu_seat_from_seat(grab_seat, launcher_menu);
+    if ( self == NULL )
     {
-        wl_resource_post_error(self->binding, ZWW_LAUNCHER_MENU_V1_ERROR_UNIQUE, "another surface has this role already");
-        return;
+        wl_client_post_no_memory(client);
+        return NULL;
     }
 
-    if ( weston_surface_set_role(surface, "ww_launcher_menu", self->binding, ZWW_LAUNCHER_MENU_V1_ERROR_ROLE) < 0 )
-        return;
+    if ( ( self->surface != NULL ) || ( ( surface->committed == _weston_launcher_menu_surface_committed ) && ( surface->committed_private != NULL ) ) )
+    {
+        wl_resource_post_error(launcher_menu->binding, ZWW_LAUNCHER_MENU_V1_ERROR_UNIQUE, "another surface has this role already");
+        return NULL;
+    }
 
-    self->surface = surface;
-    self->view = weston_view_create(self->surface);
+    if ( weston_surface_set_role(surface, "ww_launcher_menu", launcher_menu->binding, ZWW_LAUNCHER_MENU_V1_ERROR_ROLE) < 0 )
+        return NULL;
+
+    self->view = weston_view_create(surface);
     if ( self->view == NULL )
     {
         wl_client_post_no_memory(client);
-        return;
+        return NULL;
     }
+    self->surface = surface;
 
     self->surface->committed = _weston_launcher_menu_surface_committed;
     self->surface->committed_private = self;
@@ -437,34 +858,49 @@ _weston_launcher_menu_show_common(struct weston_launcher_menu *self, struct wl_c
     if ( ( keyboard != NULL ) && ( keyboard->focus != NULL ) && ( keyboard->focus->output != NULL ) )
         self->output = keyboard->focus->output;
     else
-        self->output = _weston_launcher_menu_get_default_output(self);
+        self->output = _weston_launcher_menu_get_default_output(launcher_menu);
 
     self->surface_destroy_listener.notify = _weston_launcher_menu_surface_destroyed;
     self->view_destroy_listener.notify = _weston_launcher_menu_view_destroyed;
     wl_signal_add(&self->surface->destroy_signal, &self->surface_destroy_listener);
     wl_signal_add(&self->view->destroy_signal, &self->view_destroy_listener);
 
-    self->grab_seat = _weston_launcher_menu_seat_from_seat(grab_seat, self);
-    _weston_launcher_menu_seat_grab_start(self->grab_seat);
+    self->grab.show_time = ww_stats_start();
+    self->grab.over_quota = false;
+    _weston_launcher_menu_seat_grab_start(self);
+
+    return self;
 }
 
 static void
 _weston_launcher_menu_show(struct wl_client *client, struct wl_resource *resource, struct wl_resource *surface_resource)
 {
-    struct weston_launcher_menu *self = wl_resource_get_user_data(resource);
+    WW_TRACE_SCOPE();
+
+    struct weston_launcher_menu *launcher_menu = wl_resource_get_user_data(resource);
     struct weston_surface *surface = wl_resource_get_user_data(surface_resource);
-    struct weston_seat *wseat = _weston_launcher_menu_get_default_seat(self);
+    struct weston_seat *wseat = _weston_launcher_menu_get_default_seat(launcher_menu);
+    struct weston_launcher_menu_seat *self;
+
+    if ( wseat == NULL )
+        return;
 
-    _weston_launcher_menu_show_common(self, client, surface, wseat);
-    self->position = WESTON_LAUNCHER_MENU_POSITION_DEFAULT;
+    self = _weston_launcher_menu_show_common(launcher_menu, client, surface, wseat);
+    if ( self == NULL )
+        return;
+
+    _weston_launcher_menu_seat_set_default_positioner(self);
 }
 
 static void
 _weston_launcher_menu_show_at_pointer(struct wl_client *client, struct wl_resource *resource, struct wl_resource *surface_resource, struct wl_resource *seat_resource, uint32_t serial)
 {
-    struct weston_launcher_menu *self = wl_resource_get_user_data(resource);
+    WW_TRACE_SCOPE();
+
+    struct weston_launcher_menu *launcher_menu = wl_resource_get_user_data(resource);
     struct weston_surface *surface = wl_resource_get_user_data(surface_resource);
     struct weston_seat *wseat = wl_resource_get_user_data(seat_resource);
+    struct weston_launcher_menu_seat *self;
 
     struct weston_pointer *pointer = weston_seat_get_pointer(wseat);
 
@@ -474,16 +910,33 @@ _weston_launcher_menu_show_at_pointer(struct wl_client *client, struct wl_resour
         return;
     }
 
-    _weston_launcher_menu_show_common(self, client, surface, wseat);
-    self->position = WESTON_LAUNCHER_MENU_POSITION_POINTER;
+    self = _weston_launcher_menu_show_common(launcher_menu, client, surface, wseat);
+    if ( self == NULL )
+        return;
+
+    struct weston_launcher_menu_positioner positioner = {
+        .anchor_rect = {
+            .x = wl_fixed_to_int(pointer->x),
+            .y = wl_fixed_to_int(pointer->y),
+            .width = 1,
+            .height = 1,
+        },
+        .anchor = WESTON_LAUNCHER_MENU_EDGE_TOP | WESTON_LAUNCHER_MENU_EDGE_LEFT,
+        .gravity = WESTON_LAUNCHER_MENU_EDGE_BOTTOM | WESTON_LAUNCHER_MENU_EDGE_RIGHT,
+        .constraints = WESTON_LAUNCHER_MENU_CONSTRAINT_FLIP_X | WESTON_LAUNCHER_MENU_CONSTRAINT_FLIP_Y | WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_X | WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_Y,
+    };
+    _weston_launcher_menu_seat_set_positioner(self, &positioner);
 }
 
 static void
 _weston_launcher_menu_show_at_surface(struct wl_client *client, struct wl_resource *resource, struct wl_resource *surface_resource, struct wl_resource *seat_resource, uint32_t serial, int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    struct weston_launcher_menu *self = wl_resource_get_user_data(resource);
+    WW_TRACE_SCOPE();
+
+    struct weston_launcher_menu *launcher_menu = wl_resource_get_user_data(resource);
     struct weston_surface *surface = wl_resource_get_user_data(surface_resource);
     struct weston_seat *wseat = wl_resource_get_user_data(seat_resource);
+    struct weston_launcher_menu_seat *self;
 
     struct weston_keyboard *keyboard = weston_seat_get_keyboard(wseat);
     struct weston_pointer *pointer = weston_seat_get_pointer(wseat);
@@ -491,7 +944,11 @@ _weston_launcher_menu_show_at_surface(struct wl_client *client, struct wl_resour
 
     struct weston_view *target = NULL;
     if ( ( keyboard != NULL ) && ( keyboard->grab_serial == serial ) )
-        target = wl_container_of(keyboard->focus->views.next, target, link);
+    {
+        /* The focus may be gone (or not mapped), fall back to output placement */
+        if ( ( keyboard->focus != NULL ) && ( ! wl_list_empty(&keyboard->focus->views) ) )
+            target = wl_container_of(keyboard->focus->views.next, target, surface_link);
+    }
     else if ( ( pointer != NULL ) && ( pointer->grab_serial == serial ) )
         target = pointer->focus;
     else if ( ( touch != NULL ) && ( touch->grab_serial == serial ) )
@@ -502,13 +959,28 @@ _weston_launcher_menu_show_at_surface(struct wl_client *client, struct wl_resour
         return;
     }
 
-    _weston_launcher_menu_show_common(self, client, surface, wseat);
-    self->position = WESTON_LAUNCHER_MENU_POSITION_SURFACE;
-    self->target.view = target;
-    self->target.geometry.x = x;
-    self->target.geometry.y = y;
-    self->target.geometry.width = width;
-    self->target.geometry.height = height;
+    self = _weston_launcher_menu_show_common(launcher_menu, client, surface, wseat);
+    if ( self == NULL )
+        return;
+
+    if ( target == NULL )
+    {
+        _weston_launcher_menu_seat_set_default_positioner(self);
+        return;
+    }
+
+    struct weston_launcher_menu_positioner positioner = {
+        .anchor_rect = {
+            .x = target->geometry.x + x,
+            .y = target->geometry.y + y,
+            .width = width,
+            .height = height,
+        },
+        .anchor = WESTON_LAUNCHER_MENU_EDGE_BOTTOM | WESTON_LAUNCHER_MENU_EDGE_LEFT,
+        .gravity = WESTON_LAUNCHER_MENU_EDGE_BOTTOM | WESTON_LAUNCHER_MENU_EDGE_RIGHT,
+        .constraints = WESTON_LAUNCHER_MENU_CONSTRAINT_FLIP_Y | WESTON_LAUNCHER_MENU_CONSTRAINT_SLIDE_X,
+    };
+    _weston_launcher_menu_seat_set_positioner(self, &positioner);
 }
 
 static const struct zww_launcher_menu_v1_interface weston_launcher_menu_implementation = {
@@ -522,14 +994,47 @@ static void
 _weston_launcher_menu_unbind(struct wl_resource *resource)
 {
     struct weston_launcher_menu *self = wl_resource_get_user_data(resource);
+    struct weston_launcher_menu_seat *seat;
+
+    if ( self->binding != resource )
+        return;
 
     self->binding = NULL;
-    _weston_launcher_menu_seat_grab_end(self->grab_seat, false);
+    wl_list_for_each(seat, &self->seats, link)
+    {
+        if ( seat->surface != NULL )
+            _weston_launcher_menu_seat_grab_end(seat, false);
+    }
+}
+
+static void
+_weston_launcher_menu_send_desktop_index(struct weston_launcher_menu *self)
+{
+    uint32_t size;
+    int fd;
+
+    if ( ( self->index == NULL ) || ( self->binding == NULL ) || ( wl_resource_get_version(self->binding) < ZWW_LAUNCHER_MENU_V1_DESKTOP_INDEX_SINCE_VERSION ) )
+        return;
+
+    /* Nothing to send until the first scan is done */
+    fd = weston_launcher_menu_index_get_fd(self->index, &size);
+    if ( fd >= 0 )
+        zww_launcher_menu_v1_send_desktop_index(self->binding, fd, size);
+}
+
+static void
+_weston_launcher_menu_index_updated(void *data)
+{
+    struct weston_launcher_menu *self = data;
+
+    _weston_launcher_menu_send_desktop_index(self);
 }
 
 static void
 _weston_launcher_menu_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_launcher_menu *self = data;
     struct wl_resource *resource;
 
@@ -544,36 +1049,85 @@ _weston_launcher_menu_bind(struct wl_client *client, void *data, uint32_t versio
     }
 
     self->binding = resource;
+
+    _weston_launcher_menu_send_desktop_index(self);
 }
 
 static void
 _weston_launcher_menu_output_destroyed(struct wl_listener *listener, void *data)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_launcher_menu *self = wl_container_of(listener, self, output_destroyed_listener);
     struct weston_output *woutput = data;
+    struct weston_launcher_menu_seat *seat;
+
+    wl_list_for_each(seat, &self->seats, link)
+    {
+        if ( seat->motion.output == woutput )
+            _weston_launcher_menu_seat_motion_flush(seat);
+
+        if ( seat->output != woutput )
+            continue;
+
+        seat->output = _weston_launcher_menu_get_default_output(self);
+        if ( ( seat->output != NULL ) && ( seat->view != NULL ) && weston_view_is_mapped(seat->view) )
+            _weston_launcher_menu_surface_update_position(seat);
+    }
 }
 
+static void
+_weston_launcher_menu_stats(void *data, struct ww_stats_sink *sink)
+{
+    struct weston_launcher_menu *self = data;
+
+    ww_stats_counter(sink, "grabs-started", self->stats.grabs_started);
+    ww_stats_counter(sink, "grabs-dismissed", self->stats.grabs_dismissed);
+    ww_stats_histogram(sink, "map-latency", &self->stats.map_latency);
+}
+
+#ifdef WW_COMBINED_MODULE
+int
+weston_launcher_menu_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#else /* ! WW_COMBINED_MODULE */
 WW_EXPORT int
 wet_module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#endif /* ! WW_COMBINED_MODULE */
 {
     struct weston_launcher_menu *self;
 
+    ww_trace_init(compositor);
+    ww_quota_init(compositor);
+
     self = zalloc(sizeof(struct weston_launcher_menu));
     if ( self == NULL )
         return -1;
 
     self->compositor = compositor;
 
+    struct weston_config_section *section = weston_config_get_section(wet_get_config(self->compositor), "launcher-menu", NULL, NULL);
+    int coalesce_motion;
+    weston_config_section_get_bool(section, "coalesce-motion", &coalesce_motion, 0);
+    self->coalesce_motion = coalesce_motion;
+
+    int desktop_index;
+    weston_config_section_get_bool(section, "desktop-index", &desktop_index, 0);
+    if ( desktop_index )
+        self->index = weston_launcher_menu_index_new(wl_display_get_event_loop(self->compositor->wl_display), _weston_launcher_menu_index_updated, self);
+
     wl_list_init(&self->seats);
 
-    if ( wl_global_create(self->compositor->wl_display, &zww_launcher_menu_v1_interface, 1, self, _weston_launcher_menu_bind) == NULL)
+    if ( wl_global_create(self->compositor->wl_display, &zww_launcher_menu_v1_interface, WESTON_LAUNCHER_MENU_VERSION, self, _weston_launcher_menu_bind) == NULL)
         return -1;
 
     self->output_destroyed_listener.notify = _weston_launcher_menu_output_destroyed;
     wl_signal_add(&self->compositor->output_destroyed_signal, &self->output_destroyed_listener);
 
-    weston_layer_init(&self->layer, self->compositor);
-    weston_layer_set_position(&self->layer, WESTON_LAYER_POSITION_UI);
+    self->layer = ww_layer_get(self->compositor, WESTON_LAYER_POSITION_UI);
+    if ( self->layer == NULL )
+        return -1;
+
+    ww_stats_init(compositor, "launcher-menu", _weston_launcher_menu_stats, self);
 
     return 0;
 }
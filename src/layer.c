@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+
+#include <wayland-server.h>
+#include <compositor.h>
+#include "layer.h"
+
+struct ww_layer {
+    struct wl_list link;
+    struct weston_layer layer;
+};
+
+static struct wl_list _ww_layers = { &_ww_layers, &_ww_layers };
+
+struct weston_layer *
+ww_layer_get(struct weston_compositor *compositor, uint32_t position)
+{
+    struct ww_layer *self;
+
+    wl_list_for_each(self, &_ww_layers, link)
+    {
+        if ( ( self->layer.compositor == compositor ) && ( self->layer.position == position ) )
+            return &self->layer;
+    }
+
+    self = zalloc(sizeof(struct ww_layer));
+    if ( self == NULL )
+        return NULL;
+
+    weston_layer_init(&self->layer, compositor);
+    weston_layer_set_position(&self->layer, position);
+
+    wl_list_insert(&_ww_layers, &self->link);
+
+    return &self->layer;
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "layout.h"
+
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+static int32_t
+_ww_layout_positioner_place_axis(int32_t start, int32_t length, bool anchor_start, bool anchor_end, bool gravity_start, bool gravity_end, int32_t size)
+{
+    int32_t point = start + length / 2;
+
+    if ( anchor_start && ! anchor_end )
+        point = start;
+    else if ( anchor_end && ! anchor_start )
+        point = start + length;
+
+    if ( gravity_start && ! gravity_end )
+        return point - size;
+    if ( gravity_end && ! gravity_start )
+        return point;
+    return point - size / 2;
+}
+
+static bool
+_ww_layout_positioner_fits(int32_t position, int32_t size, int32_t bounds_start, int32_t bounds_length)
+{
+    return ( position >= bounds_start ) && ( position + size <= bounds_start + bounds_length );
+}
+
+int32_t
+ww_layout_positioner_solve_axis(int32_t start, int32_t length, bool anchor_start, bool anchor_end, bool gravity_start, bool gravity_end, bool flip, bool slide, int32_t size, int32_t bounds_start, int32_t bounds_length)
+{
+    int32_t position = _ww_layout_positioner_place_axis(start, length, anchor_start, anchor_end, gravity_start, gravity_end, size);
+
+    if ( flip && ( ! _ww_layout_positioner_fits(position, size, bounds_start, bounds_length) ) )
+    {
+        int32_t flipped = _ww_layout_positioner_place_axis(start, length, anchor_end, anchor_start, gravity_end, gravity_start, size);
+        if ( _ww_layout_positioner_fits(flipped, size, bounds_start, bounds_length) )
+            position = flipped;
+    }
+
+    if ( slide )
+    {
+        position = MIN(position, bounds_start + bounds_length - size);
+        position = MAX(position, bounds_start);
+    }
+
+    return position;
+}
+
+/*
+ * The largest size that can be placed along an axis without being
+ * pushed out of the bounds, used as a hint before the client renders
+ */
+int32_t
+ww_layout_positioner_available_axis(int32_t start, int32_t length, bool anchor_start, bool anchor_end, bool gravity_start, bool gravity_end, bool flip, bool slide, int32_t bounds_start, int32_t bounds_length)
+{
+    int32_t point = _ww_layout_positioner_place_axis(start, length, anchor_start, anchor_end, false, true, 0);
+    int32_t before = point - bounds_start, after = bounds_start + bounds_length - point;
+    int32_t available;
+
+    if ( slide )
+        return bounds_length;
+
+    if ( gravity_start && ! gravity_end )
+        available = flip ? MAX(before, after) : before;
+    else if ( gravity_end && ! gravity_start )
+        available = flip ? MAX(before, after) : after;
+    else
+        available = 2 * MIN(before, after);
+
+    return MAX(available, 0);
+}
+
+struct weston_geometry
+ww_layout_workarea(const struct weston_geometry *output, const struct ww_layout_extents *extents)
+{
+    struct weston_geometry area = {
+        .x = output->x + extents->left,
+        .y = output->y + extents->top,
+        .width = output->width - extents->left - extents->right,
+        .height = output->height - extents->top - extents->bottom,
+    };
+
+    return area;
+}
+
+/* offset is the space taken by the docks already on that edge */
+void
+ww_layout_dock_position(const struct weston_geometry *output, enum ww_layout_edge edge, int32_t width, int32_t height, int32_t offset, int32_t *x, int32_t *y)
+{
+    *x = output->x;
+    *y = output->y;
+
+    switch ( edge )
+    {
+    case WW_LAYOUT_EDGE_TOP:
+        *y += offset;
+    break;
+    case WW_LAYOUT_EDGE_BOTTOM:
+        *y += output->height - height - offset;
+    break;
+    case WW_LAYOUT_EDGE_LEFT:
+        *x += offset;
+    break;
+    case WW_LAYOUT_EDGE_RIGHT:
+        *x += output->width - width - offset;
+    break;
+    }
+}
+
+/* Notifications are moved relative to the work area */
+void
+ww_layout_notification_position(const struct weston_geometry *workarea, int32_t x, int32_t y, int32_t *area_x, int32_t *area_y)
+{
+    *area_x = workarea->x + x;
+    *area_y = workarea->y + y;
+}
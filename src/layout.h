@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __WW_LAYOUT_H__
+#define __WW_LAYOUT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <compositor.h>
+
+/*
+ * Placement maths shared by the modules, working on plain geometries
+ * only so it needs nothing from a running compositor
+ */
+
+enum ww_layout_edge {
+    WW_LAYOUT_EDGE_TOP,
+    WW_LAYOUT_EDGE_BOTTOM,
+    WW_LAYOUT_EDGE_LEFT,
+    WW_LAYOUT_EDGE_RIGHT,
+};
+
+/* Space taken on each edge of an output */
+struct ww_layout_extents {
+    int32_t top;
+    int32_t bottom;
+    int32_t left;
+    int32_t right;
+};
+
+int32_t ww_layout_positioner_solve_axis(int32_t start, int32_t length, bool anchor_start, bool anchor_end, bool gravity_start, bool gravity_end, bool flip, bool slide, int32_t size, int32_t bounds_start, int32_t bounds_length);
+int32_t ww_layout_positioner_available_axis(int32_t start, int32_t length, bool anchor_start, bool anchor_end, bool gravity_start, bool gravity_end, bool flip, bool slide, int32_t bounds_start, int32_t bounds_length);
+
+struct weston_geometry ww_layout_workarea(const struct weston_geometry *output, const struct ww_layout_extents *extents);
+void ww_layout_dock_position(const struct weston_geometry *output, enum ww_layout_edge edge, int32_t width, int32_t height, int32_t offset, int32_t *x, int32_t *y);
+void ww_layout_notification_position(const struct weston_geometry *workarea, int32_t x, int32_t y, int32_t *area_x, int32_t *area_y);
+
+#endif /* __WW_LAYOUT_H__ */
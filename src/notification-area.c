@@ -38,16 +38,32 @@
 #include <wayland-server.h>
 #include <compositor.h>
 #include "unstable/notification-area/notification-area-unstable-v1-server-protocol.h"
+#include "layout.h"
+#include "weston-wall.h"
+#include "trace.h"
+#include "layer.h"
+#include "stats.h"
+#include "quota.h"
+#include "output-registry.h"
+
+/* Not in the wayland-wall protocol yet, zww_notification_v1 has no other error */
+#define WESTON_NOTIFICATION_ERROR_INVALID_BUFFER 0
 
 struct weston_notification_area {
     struct weston_compositor *compositor;
     struct wl_resource *binding;
-    struct weston_layer layer;
+    struct weston_layer *layer;
+    struct ww_output_registry outputs;
     struct weston_output *output;
     struct weston_geometry workarea;
-    struct wl_listener output_created_listener;
-    struct wl_listener output_destroyed_listener;
-    struct wl_listener output_moved_listener;
+    struct {
+        int64_t notifications;
+        int64_t mapped;
+    } stats;
+};
+
+struct weston_notification_area_output {
+    struct weston_geometry workarea;
 };
 
 struct weston_notification_area_notification {
@@ -56,11 +72,15 @@ struct weston_notification_area_notification {
     struct weston_surface *surface;
     struct weston_view *view;
     struct wl_listener view_destroy_listener;
+    bool mapped;
+    bool over_quota;
 };
 
 static void
 _weston_notification_area_request_destroy(struct wl_client *client, struct wl_resource *resource)
 {
+    WW_TRACE_SCOPE();
+
     wl_resource_destroy(resource);
 }
 
@@ -73,14 +93,27 @@ _weston_notification_area_get_default_output(struct weston_notification_area *na
     return wl_container_of(na->compositor->output_list.next, na->output, link);
 }
 
+static void
+_weston_notification_area_notification_map(struct weston_notification_area_notification *self)
+{
+    weston_layer_entry_insert(&self->na->layer->view_list, &self->view->layer_link);
+    self->view->is_mapped = true;
+    weston_fade_run(self->view, 0, 1, 400.0, NULL, NULL);
+
+    if ( ! self->mapped )
+        ww_stats_add(&self->na->stats.mapped, 1);
+    self->mapped = true;
+}
+
 static void
 _weston_notification_area_notification_request_move(struct wl_client *client, struct wl_resource *resource, int32_t x, int32_t y)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_notification_area_notification *self = wl_resource_get_user_data(resource);
     int32_t dx, dy;
 
-    x += self->na->workarea.x;
-    y += self->na->workarea.y;
+    ww_layout_notification_position(&self->na->workarea, x, y, &x, &y);
     dx = self->view->geometry.x - x;
     dy = self->view->geometry.y - y;
 
@@ -90,14 +123,57 @@ _weston_notification_area_notification_request_move(struct wl_client *client, st
 
     if ( ! weston_view_is_mapped(self->view) )
     {
-        weston_layer_entry_insert(&self->na->layer.view_list, &self->view->layer_link);
-        self->view->is_mapped = true;
-        weston_fade_run(self->view, 0, 1, 400.0, NULL, NULL);
+        if ( self->over_quota )
+            return;
+
+        _weston_notification_area_notification_map(self);
     }
     else
         weston_move_run(self->view, dx, dy, 0, 1, true, NULL, NULL);
 }
 
+static void
+_weston_notification_area_notification_update(struct weston_notification_area_notification *self, enum ww_quota_status quota)
+{
+    switch ( quota )
+    {
+    case WW_QUOTA_OK:
+        /* Shown again where the client last moved it, unless it is fading out */
+        if ( self->over_quota && self->mapped && ( self->resource != NULL ) && ( self->view != NULL ) && ! weston_view_is_mapped(self->view) )
+            _weston_notification_area_notification_map(self);
+        self->over_quota = false;
+    break;
+    case WW_QUOTA_EXCEEDED:
+        /* Hidden until the client is under quota */
+        self->over_quota = true;
+        if ( ( self->view != NULL ) && weston_view_is_mapped(self->view) )
+            weston_view_unmap(self->view);
+    break;
+    case WW_QUOTA_REJECTED:
+    break;
+    }
+}
+
+static void
+_weston_notification_area_notification_quota_changed(struct weston_surface *surface, enum ww_quota_status quota)
+{
+    /* The notification is gone */
+    if ( surface->committed_private == NULL )
+        return;
+
+    _weston_notification_area_notification_update(surface->committed_private, quota);
+}
+
+static void
+_weston_notification_area_notification_committed(struct weston_surface *surface, int32_t sx, int32_t sy)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_notification_area_notification *self = surface->committed_private;
+
+    _weston_notification_area_notification_update(self, ww_quota_account(surface, WW_QUOTA_ROLE_NOTIFICATION, self->resource, WESTON_NOTIFICATION_ERROR_INVALID_BUFFER, _weston_notification_area_notification_quota_changed));
+}
+
 static void
 _weston_notification_area_notification_view_destroyed(struct wl_listener *listener, void *data)
 {
@@ -118,6 +194,13 @@ _weston_notification_area_notification_fade_out_done(struct weston_view_animatio
 {
     struct weston_notification_area_notification *self = data;
 
+    ww_stats_add(&self->na->stats.notifications, -1);
+    if ( self->mapped )
+        ww_stats_add(&self->na->stats.mapped, -1);
+
+    /* The client may still hold the surface */
+    self->surface->committed = NULL;
+    self->surface->committed_private = NULL;
     weston_surface_destroy(self->surface);
     free(self);
 }
@@ -127,12 +210,15 @@ _weston_notification_area_notification_destroy(struct wl_resource *resource)
 {
     struct weston_notification_area_notification *self = wl_resource_get_user_data(resource);
 
+    self->resource = NULL;
     weston_fade_run(self->view, 1, 0, 400.0, _weston_notification_area_notification_fade_out_done, self);
 }
 
 static void
 _weston_notification_area_create_notification(struct wl_client *client, struct wl_resource *resource, uint32_t id, struct wl_resource *surface_resource)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_notification_area *na = wl_resource_get_user_data(resource);
     struct weston_surface *surface = wl_resource_get_user_data(surface_resource);
 
@@ -168,9 +254,13 @@ _weston_notification_area_create_notification(struct wl_client *client, struct w
     }
 
     ++self->surface->ref_count;
+    self->surface->committed = _weston_notification_area_notification_committed;
+    self->surface->committed_private = self;
     self->view_destroy_listener.notify = _weston_notification_area_notification_view_destroyed;
     wl_signal_add(&self->view->destroy_signal, &self->view_destroy_listener);
     wl_resource_set_implementation(self->resource, &weston_notification_area_notification_implementation, self, _weston_notification_area_notification_destroy);
+
+    ww_stats_add(&na->stats.notifications, 1);
 }
 
 static const struct zww_notification_area_v1_interface weston_notification_area_implementation = {
@@ -178,28 +268,32 @@ static const struct zww_notification_area_v1_interface weston_notification_area_
     .create_notification = _weston_notification_area_create_notification,
 };
 
+static void
+_weston_notification_area_output_update_workarea(struct weston_notification_area_output *self, struct weston_output *output)
+{
+    /* TODO: Support dock area API */
+    self->workarea.x = output->x;
+    self->workarea.y = output->y;
+    self->workarea.width = output->width;
+    self->workarea.height = output->height;
+}
+
 static void
 _weston_notification_area_set_output(struct weston_notification_area *na, struct weston_output *output)
 {
+    struct weston_notification_area_output *state = ww_output_registry_get(&na->outputs, output);
     struct weston_geometry workarea = { 0, 0, 0, 0 };
+
     na->output = output;
-    if ( na->output != NULL )
-    {
-        /* TODO: Support dock area API */
-        {
-            workarea.x = na->output->x;
-            workarea.y = na->output->y;
-            workarea.width = na->output->width;
-            workarea.height = na->output->height;
-        }
-    }
+    if ( state != NULL )
+        workarea = state->workarea;
 
     if ( ( na->workarea.x == workarea.x ) && ( na->workarea.y == workarea.y ) && ( na->workarea.width == workarea.width ) && ( na->workarea.height == workarea.height ) )
         return;
 
     na->workarea = workarea;
 
-    if ( na->binding != NULL )
+    if ( ( na->binding != NULL ) && ( na->output != NULL ) )
         zww_notification_area_v1_send_geometry(na->binding, na->workarea.width, na->workarea.height, na->output->current_scale);
 }
 
@@ -214,6 +308,8 @@ _weston_notification_area_unbind(struct wl_resource *resource)
 static void
 _weston_notification_area_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
 {
+    WW_TRACE_SCOPE();
+
     struct weston_notification_area *na = data;
     struct wl_resource *resource;
 
@@ -236,57 +332,86 @@ _weston_notification_area_bind(struct wl_client *client, void *data, uint32_t ve
 }
 
 static void
-_weston_notification_area_output_created(struct wl_listener *listener, void *data)
+_weston_notification_area_output_created(void *data, struct weston_output *output, void *state)
 {
-    struct weston_notification_area *na = wl_container_of(listener, na, output_created_listener);
+    WW_TRACE_SCOPE();
+
+    struct weston_notification_area *na = data;
+
+    _weston_notification_area_output_update_workarea(state, output);
 
     if ( na->output == NULL )
         _weston_notification_area_set_output(na, _weston_notification_area_get_default_output(na));
 }
 
 static void
-_weston_notification_area_output_destroyed(struct wl_listener *listener, void *data)
+_weston_notification_area_output_destroyed(void *data, struct weston_output *output, void *state)
 {
-    struct weston_notification_area *na = wl_container_of(listener, na, output_destroyed_listener);
-    struct weston_output *output = data;
+    WW_TRACE_SCOPE();
+
+    struct weston_notification_area *na = data;
 
     if ( na->output == output )
         _weston_notification_area_set_output(na, _weston_notification_area_get_default_output(na));
 }
 
 static void
-_weston_notification_area_output_moved(struct wl_listener *listener, void *data)
+_weston_notification_area_output_moved(void *data, struct weston_output *output, void *state)
 {
-    struct weston_notification_area *na = wl_container_of(listener, na, output_moved_listener);
-    struct weston_output *output = data;
+    WW_TRACE_SCOPE();
+
+    struct weston_notification_area *na = data;
+
+    _weston_notification_area_output_update_workarea(state, output);
 
     if ( na->output == output )
         _weston_notification_area_set_output(na, na->output);
 }
 
+static const struct ww_output_registry_interface _weston_notification_area_output_interface = {
+    .created = _weston_notification_area_output_created,
+    .moved = _weston_notification_area_output_moved,
+    .destroyed = _weston_notification_area_output_destroyed,
+};
+
+static void
+_weston_notification_area_stats(void *data, struct ww_stats_sink *sink)
+{
+    struct weston_notification_area *na = data;
+
+    ww_stats_counter(sink, "notifications", na->stats.notifications);
+    ww_stats_counter(sink, "mapped", na->stats.mapped);
+}
+
+#ifdef WW_COMBINED_MODULE
+int
+weston_notification_area_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#else /* ! WW_COMBINED_MODULE */
 WW_EXPORT int
 wet_module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#endif /* ! WW_COMBINED_MODULE */
 {
     struct weston_notification_area *na;
 
+    ww_trace_init(compositor);
+    ww_quota_init(compositor);
+
     na = zalloc(sizeof(struct weston_notification_area));
     if ( na == NULL )
         return -1;
 
     na->compositor = compositor;
 
-    na->output_created_listener.notify = _weston_notification_area_output_created;
-    na->output_destroyed_listener.notify = _weston_notification_area_output_destroyed;
-    na->output_moved_listener.notify = _weston_notification_area_output_moved;
-    wl_signal_add(&na->compositor->output_created_signal, &na->output_created_listener);
-    wl_signal_add(&na->compositor->output_destroyed_signal, &na->output_destroyed_listener);
-    wl_signal_add(&na->compositor->output_moved_signal, &na->output_moved_listener);
+    ww_output_registry_init(&na->outputs, na->compositor, sizeof(struct weston_notification_area_output), &_weston_notification_area_output_interface, na);
 
     if ( wl_global_create(na->compositor->wl_display, &zww_notification_area_v1_interface, 1, na, _weston_notification_area_bind) == NULL)
         return -1;
 
-    weston_layer_init(&na->layer, na->compositor);
-    weston_layer_set_position(&na->layer, WESTON_LAYER_POSITION_UI);
+    na->layer = ww_layer_get(na->compositor, WESTON_LAYER_POSITION_UI);
+    if ( na->layer == NULL )
+        return -1;
+
+    ww_stats_init(compositor, "notification-area", _weston_notification_area_stats, na);
 
     return 0;
 }
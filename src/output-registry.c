@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+
+#include <wayland-server.h>
+#include <compositor.h>
+#include "output-registry.h"
+
+static void
+_ww_output_registry_add(struct ww_output_registry *self, struct weston_output *output)
+{
+    void *state;
+
+    if ( ( output->id >= WW_OUTPUT_REGISTRY_MAX ) || ( self->outputs[output->id] == output ) )
+        return;
+
+    state = zalloc(self->size);
+    if ( state == NULL )
+        return;
+
+    self->outputs[output->id] = output;
+    self->states[output->id] = state;
+
+    if ( self->interface->created != NULL )
+        self->interface->created(self->data, output, state);
+}
+
+static void
+_ww_output_registry_output_created(struct wl_listener *listener, void *data)
+{
+    struct ww_output_registry *self = wl_container_of(listener, self, output_created_listener);
+    struct weston_output *output = data;
+
+    _ww_output_registry_add(self, output);
+}
+
+static void
+_ww_output_registry_output_moved(struct wl_listener *listener, void *data)
+{
+    struct ww_output_registry *self = wl_container_of(listener, self, output_moved_listener);
+    struct weston_output *output = data;
+    void *state = ww_output_registry_get(self, output);
+
+    if ( ( state != NULL ) && ( self->interface->moved != NULL ) )
+        self->interface->moved(self->data, output, state);
+}
+
+static void
+_ww_output_registry_output_destroyed(struct wl_listener *listener, void *data)
+{
+    struct ww_output_registry *self = wl_container_of(listener, self, output_destroyed_listener);
+    struct weston_output *output = data;
+    void *state = ww_output_registry_get(self, output);
+
+    if ( state == NULL )
+        return;
+
+    if ( self->interface->destroyed != NULL )
+        self->interface->destroyed(self->data, output, state);
+
+    /* The id may be reused by the next output */
+    self->outputs[output->id] = NULL;
+    self->states[output->id] = NULL;
+    free(state);
+}
+
+void
+ww_output_registry_init(struct ww_output_registry *self, struct weston_compositor *compositor, size_t size, const struct ww_output_registry_interface *interface, void *data)
+{
+    struct weston_output *output;
+
+    self->compositor = compositor;
+    self->interface = interface;
+    self->data = data;
+    self->size = size;
+
+    self->output_created_listener.notify = _ww_output_registry_output_created;
+    self->output_moved_listener.notify = _ww_output_registry_output_moved;
+    self->output_destroyed_listener.notify = _ww_output_registry_output_destroyed;
+    wl_signal_add(&compositor->output_created_signal, &self->output_created_listener);
+    wl_signal_add(&compositor->output_moved_signal, &self->output_moved_listener);
+    wl_signal_add(&compositor->output_destroyed_signal, &self->output_destroyed_listener);
+
+    wl_list_for_each(output, &compositor->output_list, link)
+        _ww_output_registry_add(self, output);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef __WW_OUTPUT_REGISTRY_H__
+#define __WW_OUTPUT_REGISTRY_H__
+
+#include <stddef.h>
+#include <compositor.h>
+
+/*
+ * Per-module state attached to each output, allocated on hotplug and
+ * looked up by output id, as output masks do
+ */
+
+#define WW_OUTPUT_REGISTRY_MAX 32
+
+struct ww_output_registry_interface {
+    void (*created)(void *data, struct weston_output *output, void *state);
+    void (*moved)(void *data, struct weston_output *output, void *state);
+    /* The state is freed right after */
+    void (*destroyed)(void *data, struct weston_output *output, void *state);
+};
+
+struct ww_output_registry {
+    struct weston_compositor *compositor;
+    const struct ww_output_registry_interface *interface;
+    void *data;
+    size_t size;
+    struct weston_output *outputs[WW_OUTPUT_REGISTRY_MAX];
+    void *states[WW_OUTPUT_REGISTRY_MAX];
+    struct wl_listener output_created_listener;
+    struct wl_listener output_moved_listener;
+    struct wl_listener output_destroyed_listener;
+};
+
+void ww_output_registry_init(struct ww_output_registry *self, struct weston_compositor *compositor, size_t size, const struct ww_output_registry_interface *interface, void *data);
+
+static inline void *
+ww_output_registry_get(struct ww_output_registry *self, struct weston_output *output)
+{
+    if ( ( output == NULL ) || ( output->id >= WW_OUTPUT_REGISTRY_MAX ) || ( self->outputs[output->id] != output ) )
+        return NULL;
+    return self->states[output->id];
+}
+
+/* The empty branch keeps a trailing else bound to the caller's own if */
+#define ww_output_registry_for_each(state, i, registry) \
+    for ( i = 0 ; i < WW_OUTPUT_REGISTRY_MAX ; ++i ) \
+        if ( ( state = (registry)->states[i] ) == NULL ) {} else
+
+#endif /* __WW_OUTPUT_REGISTRY_H__ */
@@ -0,0 +1,379 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <sys/types.h>
+
+#include <wayland-server.h>
+#include <compositor.h>
+#include <plugin-registry.h>
+#include <weston.h>
+#include "stats.h"
+#include "quota.h"
+
+#define WW_QUOTA_API_NAME "ww_quota_v2"
+
+static const char * const _ww_quota_role_names[WW_QUOTA_ROLE_COUNT] = {
+    [WW_QUOTA_ROLE_NOTIFICATION] = "ww_notification",
+    [WW_QUOTA_ROLE_BACKGROUND] = "ww_background",
+    [WW_QUOTA_ROLE_DOCK] = "ww_dock",
+    [WW_QUOTA_ROLE_LAUNCHER_MENU] = "ww_launcher_menu",
+};
+
+struct ww_quota_api {
+    enum ww_quota_status (*account)(struct weston_surface *surface, enum ww_quota_role role, struct wl_resource *role_resource, uint32_t error, ww_quota_changed_func_t changed);
+};
+
+struct ww_quota {
+    struct wl_listener destroy_listener;
+    struct wl_list clients;
+    uint64_t buffer_quota;
+    uint64_t max_buffer_size;
+    uint64_t bytes[WW_QUOTA_ROLE_COUNT];
+};
+
+struct ww_quota_client {
+    struct wl_listener destroy_listener;
+    struct wl_list link;
+    struct wl_list surfaces;
+    struct wl_list buffers;
+    pid_t pid;
+    bool exceeded;
+    uint64_t total;
+    uint64_t bytes[WW_QUOTA_ROLE_COUNT];
+};
+
+struct ww_quota_surface {
+    struct wl_listener destroy_listener;
+    struct wl_list link;
+    struct weston_surface *surface;
+    ww_quota_changed_func_t changed;
+};
+
+struct ww_quota_buffer {
+    struct wl_listener destroy_listener;
+    struct wl_list link;
+    struct ww_quota_client *client;
+    enum ww_quota_role role;
+    uint64_t bytes;
+};
+
+/* Each module gets its own copy of these, only the first one owns the accounting */
+static const struct ww_quota_api *_ww_quota_api;
+static struct ww_quota *_ww_quota;
+
+static void
+_ww_quota_client_update(struct ww_quota_client *client, enum ww_quota_role role, uint64_t old_bytes, uint64_t bytes)
+{
+    _ww_quota->bytes[role] += bytes - old_bytes;
+    if ( client == NULL )
+        return;
+    client->bytes[role] += bytes - old_bytes;
+    client->total += bytes - old_bytes;
+}
+
+static void
+_ww_quota_client_check(struct ww_quota_client *self, struct ww_quota_surface *skip)
+{
+    struct ww_quota_surface *surface, *tmp;
+    bool exceeded = ( _ww_quota->buffer_quota > 0 ) && ( self->total > _ww_quota->buffer_quota );
+
+    if ( exceeded == self->exceeded )
+        return;
+    self->exceeded = exceeded;
+
+    /* All the surfaces of the client are hidden or shown together */
+    wl_list_for_each_safe(surface, tmp, &self->surfaces, link)
+    {
+        if ( ( surface != skip ) && ( surface->changed != NULL ) )
+            surface->changed(surface->surface, exceeded ? WW_QUOTA_EXCEEDED : WW_QUOTA_OK);
+    }
+}
+
+static void
+_ww_quota_client_destroyed(struct wl_listener *listener, void *data)
+{
+    struct ww_quota_client *self = wl_container_of(listener, self, destroy_listener);
+    struct ww_quota_surface *surface, *stmp;
+    struct ww_quota_buffer *buffer, *btmp;
+
+    /* Surfaces and buffers go away after their client */
+    wl_list_for_each_safe(surface, stmp, &self->surfaces, link)
+    {
+        wl_list_remove(&surface->link);
+        wl_list_init(&surface->link);
+    }
+    wl_list_for_each_safe(buffer, btmp, &self->buffers, link)
+    {
+        wl_list_remove(&buffer->link);
+        wl_list_init(&buffer->link);
+        buffer->client = NULL;
+    }
+
+    wl_list_remove(&self->link);
+    free(self);
+}
+
+static struct ww_quota_client *
+_ww_quota_client_get(struct wl_client *wclient)
+{
+    struct ww_quota_client *self;
+    struct wl_listener *listener;
+    uid_t uid;
+    gid_t gid;
+
+    listener = wl_client_get_destroy_listener(wclient, _ww_quota_client_destroyed);
+    if ( listener != NULL )
+        return wl_container_of(listener, self, destroy_listener);
+
+    self = zalloc(sizeof(struct ww_quota_client));
+    if ( self == NULL )
+        return NULL;
+
+    wl_client_get_credentials(wclient, &self->pid, &uid, &gid);
+    wl_list_init(&self->surfaces);
+    wl_list_init(&self->buffers);
+
+    self->destroy_listener.notify = _ww_quota_client_destroyed;
+    wl_client_add_destroy_listener(wclient, &self->destroy_listener);
+    wl_list_insert(&_ww_quota->clients, &self->link);
+
+    return self;
+}
+
+static void
+_ww_quota_surface_destroyed(struct wl_listener *listener, void *data)
+{
+    struct ww_quota_surface *self = wl_container_of(listener, self, destroy_listener);
+
+    wl_list_remove(&self->destroy_listener.link);
+    wl_list_remove(&self->link);
+    free(self);
+}
+
+static struct ww_quota_surface *
+_ww_quota_surface_get(struct weston_surface *wsurface, struct ww_quota_client *client)
+{
+    struct ww_quota_surface *self;
+    struct wl_listener *listener;
+
+    listener = wl_signal_get(&wsurface->destroy_signal, _ww_quota_surface_destroyed);
+    if ( listener != NULL )
+        return wl_container_of(listener, self, destroy_listener);
+
+    self = zalloc(sizeof(struct ww_quota_surface));
+    if ( self == NULL )
+        return NULL;
+
+    self->surface = wsurface;
+    wl_list_insert(&client->surfaces, &self->link);
+
+    self->destroy_listener.notify = _ww_quota_surface_destroyed;
+    wl_signal_add(&wsurface->destroy_signal, &self->destroy_listener);
+
+    return self;
+}
+
+static void
+_ww_quota_buffer_destroyed(struct wl_listener *listener, void *data)
+{
+    struct ww_quota_buffer *self = wl_container_of(listener, self, destroy_listener);
+
+    if ( _ww_quota != NULL )
+    {
+        _ww_quota_client_update(self->client, self->role, self->bytes, 0);
+        if ( self->client != NULL )
+            _ww_quota_client_check(self->client, NULL);
+    }
+
+    wl_list_remove(&self->destroy_listener.link);
+    wl_list_remove(&self->link);
+    free(self);
+}
+
+static uint64_t
+_ww_quota_buffer_size(struct weston_buffer *buffer)
+{
+    if ( buffer->shm_buffer != NULL )
+        return (uint64_t) wl_shm_buffer_get_stride(buffer->shm_buffer) * wl_shm_buffer_get_height(buffer->shm_buffer);
+
+    /* Estimate the texture behind other buffers */
+    return (uint64_t) buffer->width * buffer->height * 4;
+}
+
+static enum ww_quota_status
+_ww_quota_account(struct weston_surface *wsurface, enum ww_quota_role role, struct wl_resource *role_resource, uint32_t error, ww_quota_changed_func_t changed)
+{
+    struct weston_buffer *wbuffer = wsurface->buffer_ref.buffer;
+    struct ww_quota_client *client;
+    struct ww_quota_surface *self;
+    struct ww_quota_buffer *buffer;
+    uint64_t bytes;
+
+    if ( _ww_quota == NULL )
+        return WW_QUOTA_OK;
+
+    client = _ww_quota_client_get(wl_resource_get_client(wsurface->resource));
+    if ( client == NULL )
+        return WW_QUOTA_OK;
+
+    self = _ww_quota_surface_get(wsurface, client);
+    if ( self != NULL )
+        self->changed = changed;
+
+    /*
+     * A buffer is charged the first time it is attached, and until the
+     * client destroys it, so attaching NULL does not free any quota
+     */
+    if ( ( wbuffer != NULL ) && ( wl_signal_get(&wbuffer->destroy_signal, _ww_quota_buffer_destroyed) == NULL ) )
+    {
+        bytes = _ww_quota_buffer_size(wbuffer);
+        if ( ( _ww_quota->max_buffer_size > 0 ) && ( bytes > _ww_quota->max_buffer_size ) )
+        {
+            /* The role object may be gone already, the surface is not */
+            if ( role_resource != NULL )
+                wl_resource_post_error(role_resource, error, "buffer of %" PRIu64 " bytes over the %" PRIu64 " bytes limit", bytes, _ww_quota->max_buffer_size);
+            else
+                wl_resource_post_no_memory(wsurface->resource);
+            return WW_QUOTA_REJECTED;
+        }
+
+        buffer = zalloc(sizeof(struct ww_quota_buffer));
+        if ( buffer != NULL )
+        {
+            buffer->client = client;
+            buffer->role = role;
+            buffer->bytes = bytes;
+            wl_list_insert(&client->buffers, &buffer->link);
+
+            buffer->destroy_listener.notify = _ww_quota_buffer_destroyed;
+            wl_signal_add(&wbuffer->destroy_signal, &buffer->destroy_listener);
+
+            _ww_quota_client_update(client, role, 0, bytes);
+        }
+    }
+
+    /* The caller handles this surface from the returned status */
+    _ww_quota_client_check(client, self);
+
+    return client->exceeded ? WW_QUOTA_EXCEEDED : WW_QUOTA_OK;
+}
+
+static const struct ww_quota_api _ww_quota_api_owner = {
+    .account = _ww_quota_account,
+};
+
+enum ww_quota_status
+ww_quota_account(struct weston_surface *surface, enum ww_quota_role role, struct wl_resource *role_resource, uint32_t error, ww_quota_changed_func_t changed)
+{
+    if ( _ww_quota_api == NULL )
+        return WW_QUOTA_OK;
+
+    return _ww_quota_api->account(surface, role, role_resource, error, changed);
+}
+
+static void
+_ww_quota_stats(void *data, struct ww_stats_sink *sink)
+{
+    struct ww_quota *self = data;
+    struct ww_quota_client *client;
+    char name[64];
+    int i;
+
+    for ( i = 0 ; i < WW_QUOTA_ROLE_COUNT ; ++i )
+        ww_stats_counter(sink, _ww_quota_role_names[i], self->bytes[i]);
+
+    wl_list_for_each(client, &self->clients, link)
+    {
+        for ( i = 0 ; i < WW_QUOTA_ROLE_COUNT ; ++i )
+        {
+            if ( client->bytes[i] == 0 )
+                continue;
+            snprintf(name, sizeof(name), "client.%d.%s", (int) client->pid, _ww_quota_role_names[i]);
+            ww_stats_counter(sink, name, client->bytes[i]);
+        }
+    }
+}
+
+static void
+_ww_quota_compositor_destroyed(struct wl_listener *listener, void *data)
+{
+    struct ww_quota *self = wl_container_of(listener, self, destroy_listener);
+    struct ww_quota_client *client, *tmp;
+
+    /* Client and surface records go away with their objects */
+    wl_list_for_each_safe(client, tmp, &self->clients, link)
+    {
+        wl_list_remove(&client->link);
+        wl_list_init(&client->link);
+    }
+
+    _ww_quota = NULL;
+    free(self);
+}
+
+void
+ww_quota_init(struct weston_compositor *compositor)
+{
+    if ( _ww_quota_api != NULL )
+        return;
+
+    _ww_quota_api = weston_plugin_api_get(compositor, WW_QUOTA_API_NAME, sizeof(struct ww_quota_api));
+    if ( _ww_quota_api != NULL )
+        return;
+
+    struct weston_config_section *section = weston_config_get_section(wet_get_config(compositor), "weston-wall", NULL, NULL);
+    struct ww_quota *self;
+    uint32_t buffer_quota, max_buffer_size;
+
+    self = zalloc(sizeof(struct ww_quota));
+    if ( self == NULL )
+        return;
+
+    weston_config_section_get_uint(section, "buffer-quota", &buffer_quota, 0);
+    weston_config_section_get_uint(section, "max-buffer-size", &max_buffer_size, 0);
+    self->buffer_quota = (uint64_t) buffer_quota << 20;
+    self->max_buffer_size = (uint64_t) max_buffer_size << 20;
+    wl_list_init(&self->clients);
+
+    if ( weston_plugin_api_register(compositor, WW_QUOTA_API_NAME, &_ww_quota_api_owner, sizeof(struct ww_quota_api)) < 0 )
+    {
+        free(self);
+        return;
+    }
+
+    self->destroy_listener.notify = _ww_quota_compositor_destroyed;
+    wl_signal_add(&compositor->destroy_signal, &self->destroy_listener);
+
+    _ww_quota = self;
+    _ww_quota_api = &_ww_quota_api_owner;
+
+    ww_stats_init(compositor, "buffers", _ww_quota_stats, self);
+}
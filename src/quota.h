@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef __WW_QUOTA_H__
+#define __WW_QUOTA_H__
+
+#include <compositor.h>
+
+/*
+ * Buffer bytes accounted per client and per role, across all the modules
+ * A buffer is charged from its first attach to one of these surfaces until
+ * the client destroys it
+ * Configured in the [weston-wall] section:
+ *   buffer-quota: MiB a client may have attached to its surfaces, over
+ *     which none of them is mapped
+ *   max-buffer-size: MiB for a single buffer, over which an invalid buffer
+ *     error is posted on the role object of the surface
+ */
+
+enum ww_quota_role {
+    WW_QUOTA_ROLE_NOTIFICATION,
+    WW_QUOTA_ROLE_BACKGROUND,
+    WW_QUOTA_ROLE_DOCK,
+    WW_QUOTA_ROLE_LAUNCHER_MENU,
+};
+#define WW_QUOTA_ROLE_COUNT (WW_QUOTA_ROLE_LAUNCHER_MENU + 1)
+
+enum ww_quota_status {
+    WW_QUOTA_OK,
+    /* Over the client quota, the surface should not be shown */
+    WW_QUOTA_EXCEEDED,
+    /* A protocol error was posted */
+    WW_QUOTA_REJECTED,
+};
+
+/* Called on the other surfaces of a client going over or back under quota */
+typedef void (*ww_quota_changed_func_t)(struct weston_surface *surface, enum ww_quota_status status);
+
+void ww_quota_init(struct weston_compositor *compositor);
+
+/*
+ * role_resource is the object that gave the surface its role, error its
+ * protocol invalid buffer error code
+ */
+enum ww_quota_status ww_quota_account(struct weston_surface *surface, enum ww_quota_role role, struct wl_resource *role_resource, uint32_t error, ww_quota_changed_func_t changed);
+
+#endif /* __WW_QUOTA_H__ */
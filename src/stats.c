@@ -0,0 +1,279 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <wayland-server.h>
+#include <compositor.h>
+#include <plugin-registry.h>
+#include "unstable/stats/stats-unstable-v1-server-protocol.h"
+#include "stats.h"
+
+#define WW_STATS_API_NAME "ww_stats_v1"
+
+struct ww_stats_api {
+    int (*add_source)(const char *module, ww_stats_source_func_t source, void *data);
+    bool (*active)(void);
+    void (*counter)(struct ww_stats_sink *sink, const char *name, int64_t value);
+    void (*histogram)(struct ww_stats_sink *sink, const char *name, const struct ww_stats_histogram *histogram);
+};
+
+struct ww_stats_source {
+    struct wl_list link;
+    const char *module;
+    ww_stats_source_func_t source;
+    void *data;
+};
+
+struct ww_stats_sink {
+    struct wl_resource *resource;
+    const char *module;
+};
+
+struct ww_stats {
+    struct wl_global *global;
+    struct wl_listener destroy_listener;
+    struct wl_list sources;
+    struct wl_list resources;
+    uid_t uid;
+};
+
+/* Each module gets its own copy of these, only the first one owns the global */
+static const struct ww_stats_api *_ww_stats_api;
+static struct ww_stats *_ww_stats;
+
+static int
+_ww_stats_add_source(const char *module, ww_stats_source_func_t source, void *data)
+{
+    struct ww_stats_source *self;
+
+    if ( _ww_stats == NULL )
+        return -1;
+
+    self = zalloc(sizeof(struct ww_stats_source));
+    if ( self == NULL )
+        return -1;
+
+    self->module = module;
+    self->source = source;
+    self->data = data;
+
+    wl_list_insert(_ww_stats->sources.prev, &self->link);
+
+    return 0;
+}
+
+static bool
+_ww_stats_active(void)
+{
+    return ( _ww_stats != NULL ) && ( ! wl_list_empty(&_ww_stats->resources) );
+}
+
+static void
+_ww_stats_counter(struct ww_stats_sink *sink, const char *name, int64_t value)
+{
+    uint64_t v = value;
+
+    zww_stats_v1_send_counter(sink->resource, sink->module, name, v >> 32, v & 0xffffffff);
+}
+
+static void
+_ww_stats_histogram(struct ww_stats_sink *sink, const char *name, const struct ww_stats_histogram *histogram)
+{
+    struct wl_array buckets;
+    size_t n = WW_STATS_HISTOGRAM_BUCKETS;
+
+    while ( ( n > 0 ) && ( histogram->buckets[n - 1] == 0 ) )
+        --n;
+
+    /* Sent straight from the histogram, the array is only read */
+    buckets.size = buckets.alloc = n * sizeof(uint64_t);
+    buckets.data = (void *) histogram->buckets;
+
+    zww_stats_v1_send_histogram(sink->resource, sink->module, name, &buckets);
+}
+
+static const struct ww_stats_api _ww_stats_api_owner = {
+    .add_source = _ww_stats_add_source,
+    .active = _ww_stats_active,
+    .counter = _ww_stats_counter,
+    .histogram = _ww_stats_histogram,
+};
+
+bool
+ww_stats_active(void)
+{
+    return ( _ww_stats_api != NULL ) && _ww_stats_api->active();
+}
+
+uint64_t
+ww_stats_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void
+ww_stats_counter(struct ww_stats_sink *sink, const char *name, int64_t value)
+{
+    _ww_stats_api->counter(sink, name, value);
+}
+
+void
+ww_stats_histogram(struct ww_stats_sink *sink, const char *name, const struct ww_stats_histogram *histogram)
+{
+    _ww_stats_api->histogram(sink, name, histogram);
+}
+
+static void
+_ww_stats_request_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+    wl_resource_destroy(resource);
+}
+
+static void
+_ww_stats_request_query(struct wl_client *client, struct wl_resource *resource)
+{
+    struct ww_stats *self = wl_resource_get_user_data(resource);
+    struct ww_stats_source *source;
+
+    wl_list_for_each(source, &self->sources, link)
+    {
+        struct ww_stats_sink sink = {
+            .resource = resource,
+            .module = source->module,
+        };
+        source->source(source->data, &sink);
+    }
+
+    zww_stats_v1_send_done(resource);
+}
+
+static const struct zww_stats_v1_interface _ww_stats_implementation = {
+    .destroy = _ww_stats_request_destroy,
+    .query = _ww_stats_request_query,
+};
+
+static void
+_ww_stats_unbind(struct wl_resource *resource)
+{
+    wl_list_remove(wl_resource_get_link(resource));
+}
+
+static void
+_ww_stats_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
+{
+    struct ww_stats *self = data;
+    struct wl_resource *resource;
+    pid_t pid;
+    uid_t uid;
+    gid_t gid;
+
+    resource = wl_resource_create(client, &zww_stats_v1_interface, version, id);
+    if ( resource == NULL )
+    {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    wl_client_get_credentials(client, &pid, &uid, &gid);
+    if ( uid != self->uid )
+    {
+        wl_resource_post_error(resource, ZWW_STATS_V1_ERROR_DENIED, "statistics are restricted to the compositor user");
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &_ww_stats_implementation, self, _ww_stats_unbind);
+    wl_list_insert(&self->resources, wl_resource_get_link(resource));
+}
+
+static void
+_ww_stats_compositor_destroyed(struct wl_listener *listener, void *data)
+{
+    struct ww_stats *self = wl_container_of(listener, self, destroy_listener);
+    struct ww_stats_source *source, *tmp;
+    struct wl_resource *resource, *rtmp;
+
+    _ww_stats = NULL;
+
+    /* Clients may still be around, leave their links alone */
+    wl_resource_for_each_safe(resource, rtmp, &self->resources)
+        wl_list_init(wl_resource_get_link(resource));
+    wl_list_for_each_safe(source, tmp, &self->sources, link)
+        free(source);
+
+    wl_global_destroy(self->global);
+    free(self);
+}
+
+void
+ww_stats_init(struct weston_compositor *compositor, const char *module, ww_stats_source_func_t source, void *data)
+{
+    if ( _ww_stats_api == NULL )
+        _ww_stats_api = weston_plugin_api_get(compositor, WW_STATS_API_NAME, sizeof(struct ww_stats_api));
+
+    if ( _ww_stats_api == NULL )
+    {
+        struct ww_stats *self;
+
+        self = zalloc(sizeof(struct ww_stats));
+        if ( self == NULL )
+            return;
+
+        self->uid = getuid();
+        wl_list_init(&self->sources);
+        wl_list_init(&self->resources);
+
+        self->global = wl_global_create(compositor->wl_display, &zww_stats_v1_interface, 1, self, _ww_stats_bind);
+        if ( self->global == NULL )
+        {
+            free(self);
+            return;
+        }
+
+        if ( weston_plugin_api_register(compositor, WW_STATS_API_NAME, &_ww_stats_api_owner, sizeof(struct ww_stats_api)) < 0 )
+        {
+            wl_global_destroy(self->global);
+            free(self);
+            return;
+        }
+
+        self->destroy_listener.notify = _ww_stats_compositor_destroyed;
+        wl_signal_add(&compositor->destroy_signal, &self->destroy_listener);
+
+        _ww_stats = self;
+        _ww_stats_api = &_ww_stats_api_owner;
+    }
+
+    _ww_stats_api->add_source(module, source, data);
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef __WW_STATS_H__
+#define __WW_STATS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <compositor.h>
+
+/*
+ * Live statistics exposed to local tools by the zww_stats_v1 global
+ * Modules keep plain counters and histograms in their own structures
+ * and report them from a source callback, called on query only
+ */
+
+/* Values in microseconds, see stats-unstable-v1.xml for the layout */
+#define WW_STATS_HISTOGRAM_BUCKETS 240
+
+struct ww_stats_histogram {
+    uint64_t buckets[WW_STATS_HISTOGRAM_BUCKETS];
+};
+
+struct ww_stats_sink;
+typedef void (*ww_stats_source_func_t)(void *data, struct ww_stats_sink *sink);
+
+void ww_stats_init(struct weston_compositor *compositor, const char *module, ww_stats_source_func_t source, void *data);
+bool ww_stats_active(void);
+uint64_t ww_stats_now(void);
+void ww_stats_counter(struct ww_stats_sink *sink, const char *name, int64_t value);
+void ww_stats_histogram(struct ww_stats_sink *sink, const char *name, const struct ww_stats_histogram *histogram);
+
+static inline void
+ww_stats_add(int64_t *counter, int64_t value)
+{
+    __atomic_add_fetch(counter, value, __ATOMIC_RELAXED);
+}
+
+static inline void
+ww_stats_histogram_record(struct ww_stats_histogram *self, uint64_t value)
+{
+    uint32_t i = value;
+
+    if ( value > UINT32_MAX )
+        i = UINT32_MAX;
+    if ( i >= 8 )
+    {
+        uint32_t msb = 31 - __builtin_clz(i);
+        i = ( msb - 2 ) * 8 + ( ( i >> ( msb - 3 ) ) & 7 );
+    }
+    __atomic_add_fetch(&self->buckets[i], 1, __ATOMIC_RELAXED);
+}
+
+/* Starts a measure, 0 when nobody is looking */
+static inline uint64_t
+ww_stats_start(void)
+{
+    return ww_stats_active() ? ww_stats_now() : 0;
+}
+
+static inline void
+ww_stats_stop(struct ww_stats_histogram *self, uint64_t start)
+{
+    if ( start != 0 )
+        ww_stats_histogram_record(self, ww_stats_now() - start);
+}
+
+#endif /* __WW_STATS_H__ */
@@ -0,0 +1,294 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/input.h>
+
+#include <wayland-server.h>
+#include <compositor.h>
+#include <plugin-registry.h>
+#include <weston.h>
+#include "trace.h"
+
+#define WW_TRACE_API_NAME "ww_trace_v1"
+
+struct ww_trace_api {
+    void (*event)(char phase, const char *name);
+};
+
+struct ww_trace_entry {
+    uint64_t time;
+    const char *name;
+    char phase;
+};
+
+struct ww_trace {
+    struct wl_listener destroy_listener;
+    char *path;
+    pid_t pid;
+    uint32_t size;
+    uint32_t head;
+    bool wrapped;
+    struct ww_trace_entry *entries;
+};
+
+/* Each module gets its own copy of these, only the first one owns the buffer */
+static const struct ww_trace_api *_ww_trace_api;
+static struct ww_trace *_ww_trace;
+
+static void
+_ww_trace_record(char phase, const char *name)
+{
+    struct ww_trace *self = _ww_trace;
+    struct timespec ts;
+
+    if ( self == NULL )
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    struct ww_trace_entry *entry = &self->entries[self->head];
+    entry->time = (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+    entry->name = name;
+    entry->phase = phase;
+
+    if ( ++self->head == self->size )
+    {
+        self->head = 0;
+        self->wrapped = true;
+    }
+}
+
+static const struct ww_trace_api _ww_trace_api_owner = {
+    .event = _ww_trace_record,
+};
+
+void
+ww_trace_event(char phase, const char *name)
+{
+    if ( _ww_trace_api != NULL )
+        _ww_trace_api->event(phase, name);
+}
+
+/*
+ * Once the ring wrapped, it may start with the end of scopes whose
+ * beginning was overwritten, and a dump taken within a scope ends with
+ * it still open: viewers draw both as broken slices, so they are dropped
+ */
+static bool *
+_ww_trace_matched(struct ww_trace *self, uint32_t start, uint32_t n)
+{
+    struct ww_trace_entry *entry;
+    uint32_t i, depth;
+    bool *keep;
+
+    keep = malloc(n * sizeof(bool));
+    if ( keep == NULL )
+        return NULL;
+
+    for ( i = 0, depth = 0 ; i < n ; ++i )
+    {
+        entry = &self->entries[( start + i ) % self->size];
+        keep[i] = true;
+        if ( entry->phase == 'B' )
+            ++depth;
+        else if ( entry->phase == 'E' )
+        {
+            if ( depth == 0 )
+                keep[i] = false;
+            else
+                --depth;
+        }
+    }
+
+    for ( i = n, depth = 0 ; i > 0 ; --i )
+    {
+        entry = &self->entries[( start + i - 1 ) % self->size];
+        if ( ! keep[i - 1] )
+            continue;
+        if ( entry->phase == 'E' )
+            ++depth;
+        else if ( entry->phase == 'B' )
+        {
+            if ( depth == 0 )
+                keep[i - 1] = false;
+            else
+                --depth;
+        }
+    }
+
+    return keep;
+}
+
+static void
+_ww_trace_write_string(FILE *f, const char *string, size_t length)
+{
+    size_t i;
+
+    fputc('"', f);
+    for ( i = 0 ; i < length ; ++i )
+    {
+        unsigned char c = string[i];
+
+        if ( ( c == '"' ) || ( c == '\\' ) )
+            fprintf(f, "\\%c", c);
+        else if ( c < 0x20 )
+            fprintf(f, "\\u%04x", c);
+        else
+            fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+static void
+_ww_trace_dump(struct ww_trace *self)
+{
+    FILE *f;
+    uint32_t i, n, start, written = 0;
+    bool *keep;
+
+    start = self->wrapped ? self->head : 0;
+    n = self->wrapped ? self->size : self->head;
+
+    keep = _ww_trace_matched(self, start, n);
+    if ( ( keep == NULL ) && ( n > 0 ) )
+    {
+        weston_log("weston-wall: could not write trace to %s: out of memory\n", self->path);
+        return;
+    }
+
+    f = fopen(self->path, "w");
+    if ( f == NULL )
+    {
+        weston_log("weston-wall: could not write trace to %s: %m\n", self->path);
+        free(keep);
+        return;
+    }
+
+    fputs("{\"traceEvents\":[", f);
+    for ( i = 0 ; i < n ; ++i )
+    {
+        struct ww_trace_entry *entry = &self->entries[( start + i ) % self->size];
+
+        if ( ! keep[i] )
+            continue;
+
+        fputs(( written++ > 0 ) ? ",\n{\"name\":" : "\n{\"name\":", f);
+        _ww_trace_write_string(f, entry->name, strlen(entry->name));
+        fputs(",\"cat\":\"weston-wall\",\"ph\":", f);
+        _ww_trace_write_string(f, &entry->phase, 1);
+        fprintf(f, ",\"ts\":%" PRIu64 ".%03" PRIu64 ",\"pid\":%d,\"tid\":%d}", entry->time / 1000, entry->time % 1000, self->pid, self->pid);
+    }
+    fputs("\n],\"displayTimeUnit\":\"ns\"}\n", f);
+    free(keep);
+
+    if ( fclose(f) == 0 )
+        weston_log("weston-wall: trace written to %s (%" PRIu32 " events)\n", self->path, written);
+}
+
+static void
+_ww_trace_dump_binding(struct weston_keyboard *keyboard, uint32_t time, uint32_t key, void *data)
+{
+    if ( _ww_trace != NULL )
+        _ww_trace_dump(_ww_trace);
+}
+
+static void
+_ww_trace_compositor_destroyed(struct wl_listener *listener, void *data)
+{
+    struct ww_trace *self = wl_container_of(listener, self, destroy_listener);
+
+    _ww_trace_dump(self);
+
+    /* Modules may still get signals while the compositor is torn down */
+    _ww_trace = NULL;
+
+    free(self->entries);
+    free(self->path);
+    free(self);
+}
+
+void
+ww_trace_init(struct weston_compositor *compositor)
+{
+    if ( _ww_trace_api != NULL )
+        return;
+
+    _ww_trace_api = weston_plugin_api_get(compositor, WW_TRACE_API_NAME, sizeof(struct ww_trace_api));
+    if ( _ww_trace_api != NULL )
+        return;
+
+    struct weston_config_section *section = weston_config_get_section(wet_get_config(compositor), "weston-wall", NULL, NULL);
+    struct ww_trace *self = NULL;
+    int trace;
+    uint32_t size;
+    char *path;
+
+    weston_config_section_get_bool(section, "trace", &trace, false);
+    if ( ! trace )
+        return;
+
+    weston_config_section_get_uint(section, "trace-size", &size, 65536);
+    weston_config_section_get_string(section, "trace-file", &path, "/tmp/weston-wall-trace.json");
+    if ( size == 0 )
+        size = 1;
+
+    self = zalloc(sizeof(struct ww_trace));
+    if ( self == NULL )
+        goto error;
+
+    self->entries = calloc(size, sizeof(struct ww_trace_entry));
+    if ( self->entries == NULL )
+        goto error;
+
+    self->path = path;
+    self->size = size;
+    self->pid = getpid();
+    if ( weston_plugin_api_register(compositor, WW_TRACE_API_NAME, &_ww_trace_api_owner, sizeof(struct ww_trace_api)) < 0 )
+        goto error;
+
+    self->destroy_listener.notify = _ww_trace_compositor_destroyed;
+    wl_signal_add(&compositor->destroy_signal, &self->destroy_listener);
+
+    weston_compositor_add_debug_binding(compositor, KEY_W, _ww_trace_dump_binding, NULL);
+
+    _ww_trace = self;
+    _ww_trace_api = &_ww_trace_api_owner;
+    return;
+
+error:
+    if ( self != NULL )
+        free(self->entries);
+    free(self);
+    free(path);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef __WW_TRACE_H__
+#define __WW_TRACE_H__
+
+#include <compositor.h>
+
+/*
+ * Begin/end events shared by all the modules in a single ring buffer,
+ * dumped as Chrome trace JSON (chrome://tracing, Perfetto)
+ * Enabled with trace=true in the [weston-wall] section
+ */
+
+struct ww_trace_scope {
+    const char *name;
+};
+
+void ww_trace_init(struct weston_compositor *compositor);
+/* Only the name pointer is kept, it must live as long as the compositor */
+void ww_trace_event(char phase, const char *name);
+
+static inline struct ww_trace_scope
+ww_trace_scope_begin(const char *name)
+{
+    ww_trace_event('B', name);
+    return (struct ww_trace_scope) { .name = name };
+}
+
+static inline void
+ww_trace_scope_end(struct ww_trace_scope *scope)
+{
+    ww_trace_event('E', scope->name);
+}
+
+/* Traces the enclosing function until it returns */
+#define WW_TRACE_SCOPE() struct ww_trace_scope _ww_trace_scope __attribute__((cleanup(ww_trace_scope_end))) = ww_trace_scope_begin(__func__)
+
+#endif /* __WW_TRACE_H__ */
@@ -0,0 +1,60 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+
+#include <wayland-server.h>
+#include <compositor.h>
+#include "weston-wall.h"
+
+static const struct {
+    const char *name;
+    int (*init)(struct weston_compositor *compositor, int *argc, char *argv[]);
+} _weston_wall_modules[] = {
+    { "background", weston_background_init },
+    { "dock-manager", weston_dock_manager_init },
+    { "notification-area", weston_notification_area_init },
+    { "launcher-menu", weston_launcher_menu_init },
+    { "window-switcher", weston_window_switcher_init },
+};
+
+WW_EXPORT int
+wet_module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+{
+    size_t i;
+
+    for ( i = 0 ; i < sizeof(_weston_wall_modules) / sizeof(_weston_wall_modules[0]) ; ++i )
+    {
+        if ( _weston_wall_modules[i].init(compositor, argc, argv) < 0 )
+        {
+            weston_log("weston-wall: could not initialise %s\n", _weston_wall_modules[i].name);
+            return -1;
+        }
+    }
+
+    return 0;
+}
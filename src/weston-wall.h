@@ -0,0 +1,36 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef __WESTON_WALL_H__
+#define __WESTON_WALL_H__
+
+#include <compositor.h>
+
+/* Module entry points, when built together as weston-wall.so */
+int weston_background_init(struct weston_compositor *compositor, int *argc, char *argv[]);
+int weston_dock_manager_init(struct weston_compositor *compositor, int *argc, char *argv[]);
+int weston_notification_area_init(struct weston_compositor *compositor, int *argc, char *argv[]);
+int weston_launcher_menu_init(struct weston_compositor *compositor, int *argc, char *argv[]);
+int weston_window_switcher_init(struct weston_compositor *compositor, int *argc, char *argv[]);
+
+#endif /* __WESTON_WALL_H__ */
@@ -0,0 +1,405 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <wayland-server.h>
+#include "window-switcher-search.h"
+
+#define WESTON_WINDOW_SWITCHER_SEARCH_MIN_SIZE 64
+
+struct weston_window_switcher_search_posting {
+    uint32_t trigram;
+    size_t count;
+    size_t size;
+    struct weston_window_switcher_search_document **documents;
+};
+
+struct weston_window_switcher_search {
+    struct wl_list documents;
+    struct wl_list unindexed;
+    size_t size;
+    size_t used;
+    struct weston_window_switcher_search_posting *postings;
+};
+
+/* Documents we could not index, for lack of memory, are found by a scan */
+struct weston_window_switcher_search_document {
+    struct wl_list link;
+    struct wl_list unindexed_link;
+    void *data;
+    char *text;
+    size_t trigram_count;
+    uint32_t *trigrams;
+};
+
+static uint32_t
+_weston_window_switcher_search_trigram(const char *s)
+{
+    return ( (uint32_t) (unsigned char) s[0] << 16 ) | ( (uint32_t) (unsigned char) s[1] << 8 ) | (uint32_t) (unsigned char) s[2];
+}
+
+static uint32_t
+_weston_window_switcher_search_hash(uint32_t trigram)
+{
+    return trigram * 2654435761U;
+}
+
+/* Open addressing, no trigram is ever 0 as strings have no NUL byte */
+static struct weston_window_switcher_search_posting *
+_weston_window_switcher_search_lookup(struct weston_window_switcher_search *self, uint32_t trigram)
+{
+    size_t i;
+
+    for ( i = _weston_window_switcher_search_hash(trigram) & ( self->size - 1 ) ; self->postings[i].trigram != 0 ; i = ( i + 1 ) & ( self->size - 1 ) )
+    {
+        if ( self->postings[i].trigram == trigram )
+            return &self->postings[i];
+    }
+
+    return &self->postings[i];
+}
+
+static bool
+_weston_window_switcher_search_resize(struct weston_window_switcher_search *self, size_t size)
+{
+    struct weston_window_switcher_search_posting *old = self->postings;
+    size_t old_size = self->size, i;
+
+    self->postings = calloc(size, sizeof(struct weston_window_switcher_search_posting));
+    if ( self->postings == NULL )
+    {
+        self->postings = old;
+        return false;
+    }
+    self->size = size;
+
+    for ( i = 0 ; i < old_size ; ++i )
+    {
+        if ( old[i].trigram != 0 )
+            *_weston_window_switcher_search_lookup(self, old[i].trigram) = old[i];
+    }
+    free(old);
+
+    return true;
+}
+
+static bool
+_weston_window_switcher_search_posting_add(struct weston_window_switcher_search *self, uint32_t trigram, struct weston_window_switcher_search_document *document)
+{
+    struct weston_window_switcher_search_posting *posting;
+
+    if ( ( ( self->used + 1 ) * 2 > self->size ) && ( ! _weston_window_switcher_search_resize(self, self->size * 2) ) )
+        return false;
+
+    posting = _weston_window_switcher_search_lookup(self, trigram);
+    if ( posting->count == posting->size )
+    {
+        size_t size = ( posting->size > 0 ) ? ( posting->size * 2 ) : 4;
+        struct weston_window_switcher_search_document **documents = realloc(posting->documents, size * sizeof(struct weston_window_switcher_search_document *));
+        if ( documents == NULL )
+            return false;
+        posting->documents = documents;
+        posting->size = size;
+    }
+
+    if ( posting->trigram == 0 )
+    {
+        posting->trigram = trigram;
+        ++self->used;
+    }
+    posting->documents[posting->count++] = document;
+
+    return true;
+}
+
+/*
+ * Empty postings are taken out of the table, shifting back the following
+ * ones of the probe sequence so no tombstone is left
+ * The table shrinks when it gets sparse
+ */
+static void
+_weston_window_switcher_search_posting_delete(struct weston_window_switcher_search *self, struct weston_window_switcher_search_posting *posting)
+{
+    size_t mask = self->size - 1, i = posting - self->postings, j = i, k;
+
+    free(posting->documents);
+    memset(posting, 0, sizeof(struct weston_window_switcher_search_posting));
+    --self->used;
+
+    for ( j = ( j + 1 ) & mask ; self->postings[j].trigram != 0 ; j = ( j + 1 ) & mask )
+    {
+        k = _weston_window_switcher_search_hash(self->postings[j].trigram) & mask;
+
+        /* Entries whose home slot is cyclically in ]i, j] stay */
+        if ( ( i <= j ) ? ( ( i < k ) && ( k <= j ) ) : ( ( i < k ) || ( k <= j ) ) )
+            continue;
+
+        self->postings[i] = self->postings[j];
+        memset(&self->postings[j], 0, sizeof(struct weston_window_switcher_search_posting));
+        i = j;
+    }
+
+    if ( ( self->size > WESTON_WINDOW_SWITCHER_SEARCH_MIN_SIZE ) && ( self->used * 8 < self->size ) )
+        _weston_window_switcher_search_resize(self, self->size / 2);
+}
+
+static void
+_weston_window_switcher_search_posting_remove(struct weston_window_switcher_search *self, uint32_t trigram, struct weston_window_switcher_search_document *document)
+{
+    struct weston_window_switcher_search_posting *posting = _weston_window_switcher_search_lookup(self, trigram);
+    size_t i;
+
+    for ( i = 0 ; i < posting->count ; ++i )
+    {
+        if ( posting->documents[i] != document )
+            continue;
+
+        posting->documents[i] = posting->documents[--posting->count];
+        if ( posting->count == 0 )
+            _weston_window_switcher_search_posting_delete(self, posting);
+        return;
+    }
+}
+
+static int
+_weston_window_switcher_search_trigram_compare(const void *a_, const void *b_)
+{
+    uint32_t a = *(const uint32_t *) a_, b = *(const uint32_t *) b_;
+
+    return ( a > b ) - ( a < b );
+}
+
+static void
+_weston_window_switcher_search_document_unindex(struct weston_window_switcher_search *self, struct weston_window_switcher_search_document *document)
+{
+    size_t i;
+
+    for ( i = 0 ; i < document->trigram_count ; ++i )
+        _weston_window_switcher_search_posting_remove(self, document->trigrams[i], document);
+
+    free(document->trigrams);
+    document->trigrams = NULL;
+    document->trigram_count = 0;
+    wl_list_insert(&self->unindexed, &document->unindexed_link);
+}
+
+static void
+_weston_window_switcher_search_document_clear(struct weston_window_switcher_search *self, struct weston_window_switcher_search_document *document)
+{
+    size_t i;
+
+    for ( i = 0 ; i < document->trigram_count ; ++i )
+        _weston_window_switcher_search_posting_remove(self, document->trigrams[i], document);
+    wl_list_remove(&document->unindexed_link);
+    wl_list_init(&document->unindexed_link);
+
+    free(document->trigrams);
+    free(document->text);
+    document->trigrams = NULL;
+    document->trigram_count = 0;
+    document->text = NULL;
+}
+
+static char *
+_weston_window_switcher_search_lower(const char *s, size_t length, char *out)
+{
+    size_t i;
+
+    for ( i = 0 ; i < length ; ++i )
+        out[i] = ( ( s[i] >= 'A' ) && ( s[i] <= 'Z' ) ) ? ( s[i] - 'A' + 'a' ) : s[i];
+    out[length] = '\0';
+
+    return out;
+}
+
+struct weston_window_switcher_search *
+weston_window_switcher_search_new(void)
+{
+    struct weston_window_switcher_search *self;
+
+    self = calloc(1, sizeof(struct weston_window_switcher_search));
+    if ( self == NULL )
+        return NULL;
+
+    self->size = WESTON_WINDOW_SWITCHER_SEARCH_MIN_SIZE;
+    self->postings = calloc(self->size, sizeof(struct weston_window_switcher_search_posting));
+    if ( self->postings == NULL )
+    {
+        free(self);
+        return NULL;
+    }
+
+    wl_list_init(&self->documents);
+    wl_list_init(&self->unindexed);
+
+    return self;
+}
+
+void
+weston_window_switcher_search_free(struct weston_window_switcher_search *self)
+{
+    struct weston_window_switcher_search_document *document, *tmp;
+    size_t i;
+
+    wl_list_for_each_safe(document, tmp, &self->documents, link)
+        weston_window_switcher_search_remove(self, document);
+
+    for ( i = 0 ; i < self->size ; ++i )
+        free(self->postings[i].documents);
+    free(self->postings);
+
+    free(self);
+}
+
+struct weston_window_switcher_search_document *
+weston_window_switcher_search_add(struct weston_window_switcher_search *self, void *data)
+{
+    struct weston_window_switcher_search_document *document;
+
+    document = calloc(1, sizeof(struct weston_window_switcher_search_document));
+    if ( document == NULL )
+        return NULL;
+
+    document->data = data;
+    wl_list_insert(self->documents.prev, &document->link);
+    wl_list_init(&document->unindexed_link);
+
+    return document;
+}
+
+void
+weston_window_switcher_search_remove(struct weston_window_switcher_search *self, struct weston_window_switcher_search_document *document)
+{
+    _weston_window_switcher_search_document_clear(self, document);
+    wl_list_remove(&document->link);
+
+    free(document);
+}
+
+void
+weston_window_switcher_search_update(struct weston_window_switcher_search *self, struct weston_window_switcher_search_document *document, const char *title, const char *app_id)
+{
+    size_t title_length, app_id_length, length, i, j;
+
+    _weston_window_switcher_search_document_clear(self, document);
+
+    /* Both strings are indexed as one text, split on a byte no query contains */
+    title_length = ( title != NULL ) ? strlen(title) : 0;
+    app_id_length = ( app_id != NULL ) ? strlen(app_id) : 0;
+    length = title_length + 1 + app_id_length;
+
+    document->text = malloc(length + 1);
+    if ( document->text == NULL )
+        return;
+    _weston_window_switcher_search_lower(title, title_length, document->text);
+    document->text[title_length] = '\n';
+    _weston_window_switcher_search_lower(app_id, app_id_length, document->text + title_length + 1);
+
+    if ( length < 3 )
+        return;
+
+    document->trigrams = malloc(( length - 2 ) * sizeof(uint32_t));
+    if ( document->trigrams == NULL )
+    {
+        wl_list_insert(&self->unindexed, &document->unindexed_link);
+        return;
+    }
+
+    for ( i = 0 ; i < length - 2 ; ++i )
+        document->trigrams[i] = _weston_window_switcher_search_trigram(document->text + i);
+    qsort(document->trigrams, length - 2, sizeof(uint32_t), _weston_window_switcher_search_trigram_compare);
+
+    for ( i = 0, j = 0 ; i < length - 2 ; ++i )
+    {
+        if ( ( j > 0 ) && ( document->trigrams[j - 1] == document->trigrams[i] ) )
+            continue;
+        document->trigrams[j++] = document->trigrams[i];
+    }
+    document->trigram_count = j;
+
+    for ( i = 0 ; i < document->trigram_count ; ++i )
+    {
+        if ( _weston_window_switcher_search_posting_add(self, document->trigrams[i], document) )
+            continue;
+
+        /* Only keep the text, an incomplete index would miss results */
+        document->trigram_count = i;
+        _weston_window_switcher_search_document_unindex(self, document);
+        return;
+    }
+}
+
+void
+weston_window_switcher_search_query(struct weston_window_switcher_search *self, const char *query, weston_window_switcher_search_result_func_t result, void *data)
+{
+    struct weston_window_switcher_search_document *document;
+    struct weston_window_switcher_search_posting *posting = NULL;
+    size_t length = strlen(query), i;
+    char *needle;
+
+    needle = malloc(length + 1);
+    if ( needle == NULL )
+        return;
+    _weston_window_switcher_search_lower(query, length, needle);
+
+    if ( length < 3 )
+    {
+        wl_list_for_each(document, &self->documents, link)
+        {
+            if ( ( document->text != NULL ) && ( strstr(document->text, needle) != NULL ) )
+                result(document->data, data);
+        }
+        free(needle);
+        return;
+    }
+
+    for ( i = 0 ; i < length - 2 ; ++i )
+    {
+        struct weston_window_switcher_search_posting *candidate = _weston_window_switcher_search_lookup(self, _weston_window_switcher_search_trigram(needle + i));
+        if ( ( posting == NULL ) || ( candidate->count < posting->count ) )
+            posting = candidate;
+        if ( posting->count == 0 )
+            break;
+    }
+
+    for ( i = 0 ; i < posting->count ; ++i )
+    {
+        if ( strstr(posting->documents[i]->text, needle) != NULL )
+            result(posting->documents[i]->data, data);
+    }
+
+    wl_list_for_each(document, &self->unindexed, unindexed_link)
+    {
+        if ( strstr(document->text, needle) != NULL )
+            result(document->data, data);
+    }
+
+    free(needle);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __WESTON_WINDOW_SWITCHER_SEARCH_H__
+#define __WESTON_WINDOW_SWITCHER_SEARCH_H__
+
+/*
+ * Case-insensitive (ASCII) substring search over the window titles and
+ * app_ids, backed by a trigram index updated on each change
+ * Queries of three bytes or more only verify the documents of the
+ * rarest query trigram (and those that could not be indexed), shorter
+ * ones scan every document
+ */
+struct weston_window_switcher_search;
+struct weston_window_switcher_search_document;
+
+typedef void (*weston_window_switcher_search_result_func_t)(void *document_data, void *data);
+
+struct weston_window_switcher_search *weston_window_switcher_search_new(void);
+void weston_window_switcher_search_free(struct weston_window_switcher_search *self);
+
+struct weston_window_switcher_search_document *weston_window_switcher_search_add(struct weston_window_switcher_search *self, void *data);
+void weston_window_switcher_search_remove(struct weston_window_switcher_search *self, struct weston_window_switcher_search_document *document);
+void weston_window_switcher_search_update(struct weston_window_switcher_search *self, struct weston_window_switcher_search_document *document, const char *title, const char *app_id);
+
+void weston_window_switcher_search_query(struct weston_window_switcher_search *self, const char *query, weston_window_switcher_search_result_func_t result, void *data);
+
+#endif /* __WESTON_WINDOW_SWITCHER_SEARCH_H__ */
@@ -33,216 +33,2003 @@
 #include <assert.h>
 #include <signal.h>
 #include <math.h>
+#include <time.h>
 #include <sys/types.h>
 
 #include <wayland-server.h>
 #include <compositor.h>
+#include <weston.h>
 #include <libweston-desktop.h>
 #include "unstable/window-switcher/window-switcher-unstable-v1-server-protocol.h"
+#include "window-switcher-search.h"
+#include "weston-wall.h"
+#include "trace.h"
+#include "stats.h"
 
 #define MIN(a,b) (((a) < (b)) ? (a) : (b))
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
+#define WESTON_WINDOW_SWITCHER_VERSION 2
+
 struct weston_window_switcher {
     struct weston_compositor *compositor;
-    struct wl_client *client;
-    struct wl_resource *binding;
+    struct wl_list clients;
+    struct wl_list pending;
     struct wl_list windows;
+    struct wl_list dirty;
+    uint32_t window_count;
+    struct weston_window_switcher_search *search;
+    struct wl_list outputs;
+    struct wl_list seats;
+    struct wl_list previews;
+    struct weston_layer layer;
+    struct wl_event_source *title_timer;
+    bool previews_dirty;
+    struct wl_listener create_surface_listener;
+    struct wl_listener output_created_listener;
+    struct wl_listener output_destroyed_listener;
+    struct wl_listener seat_created_listener;
+    uint32_t thumbnail_interval;
+    uint32_t title_interval;
+    uint32_t title_time;
+    enum weston_keyboard_modifier cycle_modifier;
+    struct {
+        int64_t cycles_started;
+        int64_t cycles_committed;
+        int64_t cycles_cancelled;
+        struct ww_stats_histogram update;
+        struct ww_stats_histogram search;
+    } stats;
 };
 
-struct weston_window_switcher_window {
+/*
+ * Windows are announced to version 2 clients from an idle callback after
+ * bind, so that a client switching to paged mode right away only gets the
+ * windows it asks for
+ * Older clients cannot page and get them right away
+ */
+struct weston_window_switcher_client {
     struct wl_list link;
     struct weston_window_switcher *switcher;
     struct wl_resource *resource;
+    struct wl_event_source *announce_idle;
+    bool paged;
+    bool searched;
+};
+
+struct weston_window_switcher_output {
+    struct wl_list link;
+    struct weston_window_switcher *switcher;
+    struct weston_output *output;
+    struct wl_listener frame_listener;
+};
+
+struct weston_window_switcher_seat {
+    struct wl_list link;
+    struct weston_window_switcher *switcher;
+    struct weston_seat *seat;
+    struct weston_keyboard *keyboard;
+    struct wl_listener seat_destroy_listener;
+    struct wl_listener caps_listener;
+    struct wl_listener keyboard_focus_listener;
+    struct {
+        const struct weston_pointer_grab_interface *parent;
+        struct weston_pointer_grab_interface interface;
+    } pointer;
+    struct {
+        const struct weston_touch_grab_interface *parent;
+        struct weston_touch_grab_interface interface;
+    } touch;
+    struct {
+        struct weston_keyboard_grab grab;
+        struct weston_window_switcher_window *window;
+        struct weston_view *view;
+    } cycle;
+};
+
+/*
+ * Desktop surfaces are tracked in the pending list, and are moved to the
+ * windows list once mapped
+ * The tracking structure is found from the surface destroy listener
+ * Changed windows are queued in the dirty list
+ * The windows list is kept in most-recently-used order, each window
+ * caching its rank in it so only changed ranks are sent
+ * Window state is shared and fanned out to one resource per bound client
+ */
+struct weston_window_switcher_window {
+    struct wl_list link;
+    struct weston_window_switcher *switcher;
+    struct wl_list resources;
+    struct weston_surface *wsurface;
     struct weston_desktop_surface *surface;
+    struct wl_listener surface_destroy_listener;
+    struct wl_listener surface_commit_listener;
+    struct wl_list dirty_link;
+    uint32_t dirty;
+    uint32_t mru_rank;
+    char *title;
+    char *app_id;
+    struct weston_window_switcher_search_document *search_document;
+    struct weston_geometry geometry;
+    uint32_t state;
+    uint32_t output_mask;
+    uint32_t commits;
+    struct {
+        uint32_t commits;
+        uint32_t time;
+        int32_t width;
+        int32_t height;
+        uint32_t *pixels;
+    } thumbnail;
+};
+
+static uint32_t
+_weston_window_switcher_get_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void
+_weston_window_switcher_request_destroy(struct wl_client *client, struct wl_resource *resource)
+{
+    WW_TRACE_SCOPE();
+
+    wl_resource_destroy(resource);
+}
+
+/*
+ * A preview is an extra view of the window surface, scaled into a
+ * rectangle of the switcher surface and stacked right above it, so it
+ * shows the live client buffer with no copy
+ * It follows the switcher view and goes away with it, a commit of the
+ * switcher surface catching the unmapping of a view that is kept around
+ * It takes no input, picking looks through it (see the seat grabs)
+ */
+struct weston_window_switcher_preview {
+    struct wl_list link;
+    struct weston_window_switcher_window *window;
+    struct wl_resource *resource;
+    struct weston_view *host;
+    struct wl_listener host_destroy_listener;
+    struct wl_listener host_commit_listener;
+    struct weston_view *view;
+    struct wl_listener view_destroy_listener;
+    struct weston_transform transform;
+    struct {
+        int32_t x;
+        int32_t y;
+        int32_t width;
+        int32_t height;
+    } rect;
+    struct {
+        float scale;
+        float x;
+        float y;
+    } current;
+};
+
+static void
+_weston_window_switcher_preview_free(struct weston_window_switcher_preview *self)
+{
+    wl_list_remove(&self->host_destroy_listener.link);
+    wl_list_remove(&self->host_commit_listener.link);
+    wl_list_remove(&self->view_destroy_listener.link);
+    wl_list_remove(&self->link);
+
+    free(self);
+}
+
+static void
+_weston_window_switcher_preview_destroy(struct weston_window_switcher_preview *self)
+{
+    struct weston_compositor *compositor = self->window->switcher->compositor;
+    struct weston_view *view = self->view;
+
+    _weston_window_switcher_preview_free(self);
+    weston_view_destroy(view);
+    weston_compositor_schedule_repaint(compositor);
+}
+
+static void
+_weston_window_switcher_preview_host_destroyed(struct wl_listener *listener, void *data)
+{
+    struct weston_window_switcher_preview *self = wl_container_of(listener, self, host_destroy_listener);
+
+    _weston_window_switcher_preview_destroy(self);
+}
+
+static void
+_weston_window_switcher_preview_host_committed(struct wl_listener *listener, void *data)
+{
+    struct weston_window_switcher_preview *self = wl_container_of(listener, self, host_commit_listener);
+
+    self->window->switcher->previews_dirty = true;
+}
+
+static void
+_weston_window_switcher_preview_view_destroyed(struct wl_listener *listener, void *data)
+{
+    struct weston_window_switcher_preview *self = wl_container_of(listener, self, view_destroy_listener);
+
+    _weston_window_switcher_preview_free(self);
+}
+
+static void
+_weston_window_switcher_preview_update(struct weston_window_switcher_preview *self)
+{
+    struct weston_surface *surface = self->window->wsurface;
+    float scale, x, y;
+
+    if ( ( surface->width <= 0 ) || ( surface->height <= 0 ) )
+        return;
+
+    scale = MIN((float) self->rect.width / surface->width, (float) self->rect.height / surface->height);
+    x = self->host->geometry.x + self->rect.x + ( self->rect.width - surface->width * scale ) / 2;
+    y = self->host->geometry.y + self->rect.y + ( self->rect.height - surface->height * scale ) / 2;
+
+    if ( self->host->layer_link.link.prev != &self->view->layer_link.link )
+    {
+        struct weston_layer_entry *above = wl_container_of(self->host->layer_link.link.prev, above, link);
+
+        weston_layer_entry_remove(&self->view->layer_link);
+        weston_layer_entry_insert(above, &self->view->layer_link);
+    }
+    else if ( ( scale == self->current.scale ) && ( x == self->current.x ) && ( y == self->current.y ) )
+        return;
+
+    self->current.scale = scale;
+    self->current.x = x;
+    self->current.y = y;
+
+    /* The transformation applies after the view position, so it holds both */
+    weston_matrix_init(&self->transform.matrix);
+    weston_matrix_scale(&self->transform.matrix, scale, scale, 1);
+    weston_matrix_translate(&self->transform.matrix, x, y, 0);
+    weston_view_geometry_dirty(self->view);
+    weston_view_update_transform(self->view);
+    weston_view_schedule_repaint(self->view);
+}
+
+static void
+_weston_window_switcher_update_previews(struct weston_window_switcher *switcher)
+{
+    struct weston_window_switcher_preview *self, *tmp;
+
+    wl_list_for_each_safe(self, tmp, &switcher->previews, link)
+    {
+        if ( weston_view_is_mapped(self->host) && weston_surface_is_mapped(self->host->surface) && ( ! wl_list_empty(&self->host->layer_link.link) ) )
+            _weston_window_switcher_preview_update(self);
+        else
+            _weston_window_switcher_preview_destroy(self);
+    }
+}
+
+static void
+_weston_window_switcher_remove_previews(struct weston_window_switcher *switcher, struct weston_window_switcher_window *window, struct wl_resource *resource)
+{
+    struct weston_window_switcher_preview *self, *tmp;
+
+    wl_list_for_each_safe(self, tmp, &switcher->previews, link)
+    {
+        if ( ( self->window == window ) && ( ( resource == NULL ) || ( self->resource == resource ) ) )
+            _weston_window_switcher_preview_destroy(self);
+    }
+}
+
+static bool
+_weston_window_switcher_view_is_preview(struct weston_view *view)
+{
+    return ( wl_signal_get(&view->destroy_signal, _weston_window_switcher_preview_view_destroyed) != NULL );
+}
+
+/* Our own views of the windows must not be taken for theirs */
+static bool
+_weston_window_switcher_view_is_ours(struct weston_window_switcher *switcher, struct weston_view *view)
+{
+    return ( view->layer_link.layer == &switcher->layer ) || _weston_window_switcher_view_is_preview(view);
+}
+
+/*
+ * Shells minimise windows by moving their views to a layer that is not
+ * displayed, i.e. not in the compositor layer list
+ */
+static bool
+_weston_window_switcher_view_is_displayed(struct weston_window_switcher *switcher, struct weston_view *view)
+{
+    struct weston_layer *layer = view->layer_link.layer;
+
+    return weston_view_is_mapped(view) && ( layer != NULL ) && ( ! wl_list_empty(&layer->link) ) && ( ! _weston_window_switcher_view_is_ours(switcher, view) );
+}
+
+/*
+ * Same as weston_compositor_pick_view(), looking through the previews
+ * so input over them goes to the switcher surface hosting them
+ */
+static struct weston_view *
+_weston_window_switcher_pick_view(struct weston_window_switcher *switcher, wl_fixed_t x, wl_fixed_t y, wl_fixed_t *sx, wl_fixed_t *sy)
+{
+    struct weston_view *view;
+    wl_fixed_t view_x, view_y;
+    int view_ix, view_iy;
+    int ix = wl_fixed_to_int(x);
+    int iy = wl_fixed_to_int(y);
+
+    wl_list_for_each(view, &switcher->compositor->view_list, link)
+    {
+        if ( _weston_window_switcher_view_is_preview(view) )
+            continue;
+
+        if ( ! pixman_region32_contains_point(&view->transform.boundingbox, ix, iy, NULL) )
+            continue;
+
+        weston_view_from_global_fixed(view, x, y, &view_x, &view_y);
+        view_ix = wl_fixed_to_int(view_x);
+        view_iy = wl_fixed_to_int(view_y);
+
+        if ( ! pixman_region32_contains_point(&view->surface->input, view_ix, view_iy, NULL) )
+            continue;
+        if ( view->geometry.scissor_enabled && ( ! pixman_region32_contains_point(&view->geometry.scissor, view_ix, view_iy, NULL) ) )
+            continue;
+
+        *sx = view_x;
+        *sy = view_y;
+        return view;
+    }
+
+    *sx = wl_fixed_from_int(-1000000);
+    *sy = wl_fixed_from_int(-1000000);
+    return NULL;
+}
+
+static void
+_weston_window_switcher_window_send_mru_rank(struct weston_window_switcher_window *self, struct wl_resource *resource)
+{
+    if ( wl_resource_get_version(resource) >= ZWW_WINDOW_SWITCHER_WINDOW_V1_MRU_RANK_SINCE_VERSION )
+        zww_window_switcher_window_v1_send_mru_rank(resource, self->mru_rank);
+}
+
+/*
+ * Renumber the windows from link onwards, stopping at the first one
+ * that kept its rank as all the following ones did too
+ */
+static void
+_weston_window_switcher_renumber(struct weston_window_switcher *switcher, struct wl_list *link)
+{
+    struct weston_window_switcher_window *window;
+    uint32_t rank = 0;
+
+    if ( link->prev != &switcher->windows )
+    {
+        window = wl_container_of(link->prev, window, link);
+        rank = window->mru_rank + 1;
+    }
+
+    for ( ; link != &switcher->windows ; link = link->next, ++rank )
+    {
+        window = wl_container_of(link, window, link);
+        if ( window->mru_rank == rank )
+            return;
+
+        window->mru_rank = rank;
+
+        struct wl_resource *resource;
+        wl_resource_for_each(resource, &window->resources)
+        {
+            _weston_window_switcher_window_send_mru_rank(window, resource);
+            zww_window_switcher_window_v1_send_done(resource);
+        }
+    }
+}
+
+static void
+_weston_window_switcher_update_count(struct weston_window_switcher *switcher, int32_t delta)
+{
+    switcher->window_count += delta;
+
+    struct weston_window_switcher_client *client;
+    wl_list_for_each(client, &switcher->clients, link)
+    {
+        if ( client->paged )
+            zww_window_switcher_v1_send_count(client->resource, switcher->window_count);
+    }
+}
+
+static void _weston_window_switcher_seat_cycle_end(struct weston_window_switcher_seat *self, bool commit);
+
+/* Tell the clients the window is gone, their objects are inert from now on */
+static void
+_weston_window_switcher_window_close_resources(struct weston_window_switcher_window *self)
+{
+    struct wl_resource *resource, *tmp;
+
+    wl_resource_for_each_safe(resource, tmp, &self->resources)
+    {
+        if ( wl_resource_get_version(resource) >= ZWW_WINDOW_SWITCHER_WINDOW_V1_CLOSED_SINCE_VERSION )
+            zww_window_switcher_window_v1_send_closed(resource);
+        wl_resource_set_user_data(resource, NULL);
+        wl_list_remove(wl_resource_get_link(resource));
+        wl_list_init(wl_resource_get_link(resource));
+    }
+}
+
+/*
+ * Drop everything tied to the desktop surface and move the window back
+ * to the pending list, as its surface may get a new desktop surface
+ */
+static void
+_weston_window_switcher_window_withdraw(struct weston_window_switcher_window *self)
+{
+    struct weston_window_switcher *switcher = self->switcher;
+    struct weston_window_switcher_seat *seat;
+    struct wl_list *next;
+
+    if ( self->surface == NULL )
+        return;
+
+    wl_list_for_each(seat, &switcher->seats, link)
+    {
+        if ( seat->cycle.window == self )
+            _weston_window_switcher_seat_cycle_end(seat, false);
+    }
+    _weston_window_switcher_remove_previews(switcher, self, NULL);
+    _weston_window_switcher_window_close_resources(self);
+
+    free(self->thumbnail.pixels);
+    self->thumbnail.pixels = NULL;
+    if ( self->search_document != NULL )
+        weston_window_switcher_search_remove(switcher->search, self->search_document);
+    self->search_document = NULL;
+    free(self->app_id);
+    free(self->title);
+    self->app_id = NULL;
+    self->title = NULL;
+    self->surface = NULL;
+
+    next = self->link.next;
+    wl_list_remove(&self->link);
+    wl_list_insert(&switcher->pending, &self->link);
+    _weston_window_switcher_renumber(switcher, next);
+    _weston_window_switcher_update_count(switcher, -1);
+}
+
+static void
+_weston_window_switcher_window_free(struct weston_window_switcher_window *self)
+{
+    _weston_window_switcher_window_withdraw(self);
+
+    wl_list_remove(&self->surface_destroy_listener.link);
+    wl_list_remove(&self->surface_commit_listener.link);
+    wl_list_remove(&self->dirty_link);
+    wl_list_remove(&self->link);
+
+    free(self);
+}
+
+static void
+_weston_window_switcher_window_surface_destroyed(struct wl_listener *listener, void *data)
+{
+    struct weston_window_switcher_window *self = wl_container_of(listener, self, surface_destroy_listener);
+
+    _weston_window_switcher_window_free(self);
+}
+
+/*
+ * The desktop surface goes away with its xdg_surface, which a client may
+ * destroy while keeping the wl_surface, so it is checked before each use
+ */
+static bool
+_weston_window_switcher_window_check(struct weston_window_switcher_window *self)
+{
+    if ( self->surface == NULL )
+        return false;
+
+    if ( weston_surface_get_desktop_surface(self->wsurface) == self->surface )
+        return true;
+
+    _weston_window_switcher_window_withdraw(self);
+    return false;
+}
+
+static struct weston_window_switcher_window *
+_weston_window_switcher_window_from_surface(struct weston_surface *surface)
+{
+    struct wl_listener *listener;
+    struct weston_window_switcher_window *self;
+
+    listener = wl_signal_get(&surface->destroy_signal, _weston_window_switcher_window_surface_destroyed);
+    if ( listener == NULL )
+        return NULL;
+
+    return wl_container_of(listener, self, surface_destroy_listener);
+}
+
+static void
+_weston_window_switcher_window_destroy(struct wl_resource *resource)
+{
+    struct weston_window_switcher_window *self = wl_resource_get_user_data(resource);
+
+    if ( self == NULL )
+        return;
+
+    _weston_window_switcher_remove_previews(self->switcher, self, resource);
+    wl_list_remove(wl_resource_get_link(resource));
+}
+
+static void
+_weston_window_switcher_window_set_most_recent(struct weston_window_switcher_window *self)
+{
+    struct weston_window_switcher *switcher = self->switcher;
+
+    if ( ( self->surface == NULL ) || ( switcher->windows.next == &self->link ) )
+        return;
+
+    wl_list_remove(&self->link);
+    wl_list_insert(&switcher->windows, &self->link);
+    _weston_window_switcher_renumber(switcher, &self->link);
+}
+
+/*
+ * Raise, activate and focus in one go so the next repaint is right
+ * A seat with no keyboard gets no focus, the window is still raised and
+ * activated
+ * A minimised window, with no view in a displayed layer, is left to the
+ * shell: it is neither raised nor activated nor focused
+ */
+static void
+_weston_window_switcher_window_activate(struct weston_window_switcher_window *self, struct weston_seat *seat)
+{
+    struct weston_keyboard *keyboard = weston_seat_get_keyboard(seat);
+    struct weston_view *view;
+    bool displayed = false;
+
+    wl_list_for_each(view, &self->wsurface->views, surface_link)
+    {
+        struct weston_layer *layer = view->layer_link.layer;
+
+        if ( ! _weston_window_switcher_view_is_displayed(self->switcher, view) )
+            continue;
+
+        weston_layer_entry_remove(&view->layer_link);
+        weston_layer_entry_insert(&layer->view_list, &view->layer_link);
+        weston_view_geometry_dirty(view);
+        displayed = true;
+    }
+    if ( ! displayed )
+        return;
+
+    weston_surface_damage(self->wsurface);
+    self->switcher->previews_dirty = true;
+
+    if ( ( keyboard != NULL ) && ( keyboard->focus != NULL ) )
+    {
+        struct weston_desktop_surface *focus = weston_surface_get_desktop_surface(weston_surface_get_main_surface(keyboard->focus));
+        if ( ( focus != NULL ) && ( focus != self->surface ) )
+            weston_desktop_surface_set_activated(focus, false);
+    }
+    weston_desktop_surface_set_activated(self->surface, true);
+
+    /* The keyboard focus listener keeps the order otherwise */
+    if ( keyboard != NULL )
+        weston_keyboard_set_focus(keyboard, self->wsurface);
+    else
+        _weston_window_switcher_window_set_most_recent(self);
+}
+
+/* The serial must be the one of a grab of any device of the seat */
+static bool
+_weston_window_switcher_seat_check_serial(struct weston_seat *seat, uint32_t serial)
+{
+    struct weston_keyboard *keyboard = weston_seat_get_keyboard(seat);
+    struct weston_pointer *pointer = weston_seat_get_pointer(seat);
+    struct weston_touch *touch = weston_seat_get_touch(seat);
+
+    if ( ( keyboard != NULL ) && ( keyboard->grab_serial == serial ) )
+        return true;
+    if ( ( pointer != NULL ) && ( pointer->grab_serial == serial ) )
+        return true;
+    if ( ( touch != NULL ) && ( touch->grab_serial == serial ) )
+        return true;
+    return false;
+}
+
+static void
+_weston_window_switcher_window_request_switch_to(struct wl_client *client, struct wl_resource *resource, struct wl_resource *seat_resource, uint32_t serial)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_window *self = wl_resource_get_user_data(resource);
+    struct weston_seat *seat = wl_resource_get_user_data(seat_resource);
+
+    if ( ( self == NULL ) || ( ! _weston_window_switcher_window_check(self) ) )
+        return;
+
+    if ( _weston_window_switcher_seat_check_serial(seat, serial) )
+        _weston_window_switcher_window_activate(self, seat);
+}
+
+static void
+_weston_window_switcher_window_request_close(struct wl_client *client, struct wl_resource *resource, struct wl_resource *seat_resource, uint32_t serial)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_window *self = wl_resource_get_user_data(resource);
+    struct weston_seat *seat = wl_resource_get_user_data(seat_resource);
+
+    if ( ( self == NULL ) || ( ! _weston_window_switcher_window_check(self) ) )
+        return;
+
+    if ( _weston_window_switcher_seat_check_serial(seat, serial) )
+        weston_desktop_surface_close(self->surface);
+}
+
+static void
+_weston_window_switcher_window_request_show(struct wl_client *client, struct wl_resource *resource, struct wl_resource *surface_resource, int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_window *self = wl_resource_get_user_data(resource);
+    struct weston_surface *surface = wl_resource_get_user_data(surface_resource);
+    struct weston_window_switcher_preview *preview;
+    struct weston_view *view, *host = NULL;
+
+    if ( self == NULL )
+        return;
+
+    /* Showing again moves the preview, an empty rectangle hides it */
+    _weston_window_switcher_remove_previews(self->switcher, self, resource);
+    if ( ( width <= 0 ) || ( height <= 0 ) )
+        return;
+
+    wl_list_for_each(view, &surface->views, surface_link)
+    {
+        if ( weston_view_is_mapped(view) )
+        {
+            host = view;
+            break;
+        }
+    }
+    if ( host == NULL )
+        return;
+
+    preview = zalloc(sizeof(struct weston_window_switcher_preview));
+    if ( preview == NULL )
+    {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    preview->view = weston_view_create(self->wsurface);
+    if ( preview->view == NULL )
+    {
+        free(preview);
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    preview->window = self;
+    preview->resource = resource;
+    preview->host = host;
+    preview->rect.x = x;
+    preview->rect.y = y;
+    preview->rect.width = width;
+    preview->rect.height = height;
+
+    preview->host_destroy_listener.notify = _weston_window_switcher_preview_host_destroyed;
+    preview->host_commit_listener.notify = _weston_window_switcher_preview_host_committed;
+    preview->view_destroy_listener.notify = _weston_window_switcher_preview_view_destroyed;
+    wl_signal_add(&host->destroy_signal, &preview->host_destroy_listener);
+    wl_signal_add(&host->surface->commit_signal, &preview->host_commit_listener);
+    wl_signal_add(&preview->view->destroy_signal, &preview->view_destroy_listener);
+
+    wl_list_insert(&preview->view->geometry.transformation_list, &preview->transform.link);
+    preview->view->is_mapped = true;
+    wl_list_insert(&self->switcher->previews, &preview->link);
+
+    _weston_window_switcher_preview_update(preview);
+}
+
+/*
+ * Box filter from the premultiplied RGBA read back from the renderer to
+ * premultiplied ARGB8888, source rows are summed in a flat loop that the
+ * compiler vectorises
+ */
+static void
+_weston_window_switcher_downscale(const uint8_t *src, int32_t src_width, int32_t src_height, uint32_t *dst, int32_t dst_stride, int32_t dst_width, int32_t dst_height, uint64_t *acc)
+{
+    size_t row_size = (size_t) src_width * 4;
+    int32_t dx, dy, x, y;
+
+    for ( dy = 0 ; dy < dst_height ; ++dy )
+    {
+        int32_t y0 = (int64_t) dy * src_height / dst_height;
+        int32_t y1 = MAX(y0 + 1, (int64_t) ( dy + 1 ) * src_height / dst_height);
+        size_t i;
+
+        memset(acc, 0, row_size * sizeof(uint64_t));
+        for ( y = y0 ; y < y1 ; ++y )
+        {
+            const uint8_t *row = src + y * row_size;
+            for ( i = 0 ; i < row_size ; ++i )
+                acc[i] += row[i];
+        }
+
+        for ( dx = 0 ; dx < dst_width ; ++dx )
+        {
+            int32_t x0 = (int64_t) dx * src_width / dst_width;
+            int32_t x1 = MAX(x0 + 1, (int64_t) ( dx + 1 ) * src_width / dst_width);
+            uint64_t n = (uint64_t) ( x1 - x0 ) * ( y1 - y0 );
+            uint64_t r = 0, g = 0, b = 0, a = 0;
+
+            for ( x = x0 ; x < x1 ; ++x )
+            {
+                r += acc[x * 4 + 0];
+                g += acc[x * 4 + 1];
+                b += acc[x * 4 + 2];
+                a += acc[x * 4 + 3];
+            }
+
+            dst[dy * dst_stride + dx] = ( ( a / n ) << 24 ) | ( ( r / n ) << 16 ) | ( ( g / n ) << 8 ) | ( b / n );
+        }
+    }
+}
+
+/*
+ * The thumbnail is cached at the size of the last requested buffer and
+ * is only regenerated when the surface committed since, at most once
+ * per thumbnail-interval
+ * Clients may draw in place in the same buffer, so commits are counted
+ * rather than buffers compared
+ */
+static bool
+_weston_window_switcher_window_update_thumbnail(struct weston_window_switcher_window *self, int32_t width, int32_t height)
+{
+    uint32_t now = _weston_window_switcher_get_time();
+    int32_t src_width, src_height, thumbnail_width, thumbnail_height;
+    uint8_t *src;
+    uint64_t *acc;
+    uint32_t *pixels;
+
+    if ( ( self->thumbnail.pixels != NULL ) && ( self->thumbnail.width == width ) && ( self->thumbnail.height == height ) )
+    {
+        if ( ( self->commits == self->thumbnail.commits ) || ( ( now - self->thumbnail.time ) < self->switcher->thumbnail_interval ) )
+            return true;
+    }
+
+    weston_surface_get_content_size(self->wsurface, &src_width, &src_height);
+    if ( ( src_width <= 0 ) || ( src_height <= 0 ) )
+        return false;
+
+    src = malloc((size_t) src_width * src_height * 4);
+    acc = malloc((size_t) src_width * 4 * sizeof(uint64_t));
+    pixels = calloc((size_t) width * height, sizeof(uint32_t));
+    if ( ( src == NULL ) || ( acc == NULL ) || ( pixels == NULL ) || ( weston_surface_copy_content(self->wsurface, src, (size_t) src_width * src_height * 4, 0, 0, src_width, src_height) < 0 ) )
+    {
+        free(pixels);
+        free(acc);
+        free(src);
+        return false;
+    }
+
+    if ( (int64_t) src_width * height > (int64_t) src_height * width )
+    {
+        thumbnail_width = width;
+        thumbnail_height = MAX(1, (int64_t) src_height * width / src_width);
+    }
+    else
+    {
+        thumbnail_width = MAX(1, (int64_t) src_width * height / src_height);
+        thumbnail_height = height;
+    }
+
+    _weston_window_switcher_downscale(src, src_width, src_height, pixels + ( height - thumbnail_height ) / 2 * width + ( width - thumbnail_width ) / 2, width, thumbnail_width, thumbnail_height, acc);
+    free(acc);
+    free(src);
+
+    free(self->thumbnail.pixels);
+    self->thumbnail.pixels = pixels;
+    self->thumbnail.width = width;
+    self->thumbnail.height = height;
+    self->thumbnail.time = now;
+    self->thumbnail.commits = self->commits;
+
+    return true;
+}
+
+static void
+_weston_window_switcher_window_request_get_thumbnail(struct wl_client *client, struct wl_resource *resource, struct wl_resource *buffer_resource)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_window *self = wl_resource_get_user_data(resource);
+    struct wl_shm_buffer *buffer = wl_shm_buffer_get(buffer_resource);
+    int32_t width = 0, height = 0;
+
+    if ( ( self != NULL ) && ( buffer != NULL ) && ( ( wl_shm_buffer_get_format(buffer) == WL_SHM_FORMAT_ARGB8888 ) || ( wl_shm_buffer_get_format(buffer) == WL_SHM_FORMAT_XRGB8888 ) ) )
+    {
+        int32_t stride = wl_shm_buffer_get_stride(buffer), y;
+
+        width = wl_shm_buffer_get_width(buffer);
+        height = wl_shm_buffer_get_height(buffer);
+
+        /* libwayland only checks the stride against the width in bytes, the rows would overflow the pool */
+        if ( ( width > 0 ) && ( height > 0 ) && ( stride / (int32_t) sizeof(uint32_t) >= width ) && _weston_window_switcher_window_update_thumbnail(self, width, height) )
+        {
+            uint8_t *data;
+
+            wl_shm_buffer_begin_access(buffer);
+            data = wl_shm_buffer_get_data(buffer);
+            for ( y = 0 ; y < height ; ++y )
+                memcpy(data + (size_t) y * stride, self->thumbnail.pixels + (size_t) y * width, width * sizeof(uint32_t));
+            wl_shm_buffer_end_access(buffer);
+        }
+        else
+            width = height = 0;
+    }
+
+    zww_window_switcher_window_v1_send_thumbnail(resource, buffer_resource, width, height);
+}
+
+static const struct zww_window_switcher_window_v1_interface weston_window_switcher_window_implementation = {
+    .destroy = _weston_window_switcher_request_destroy,
+    .switch_to = _weston_window_switcher_window_request_switch_to,
+    .close = _weston_window_switcher_window_request_close,
+    .show = _weston_window_switcher_window_request_show,
+    .get_thumbnail = _weston_window_switcher_window_request_get_thumbnail,
+};
+
+static bool
+_weston_window_switcher_update_string(char **cache, const char *value)
+{
+    if ( ( *cache == NULL ) ? ( value == NULL ) : ( ( value != NULL ) && ( strcmp(*cache, value) == 0 ) ) )
+        return false;
+
+    free(*cache);
+    *cache = ( value != NULL ) ? strdup(value) : NULL;
+
+    return true;
+}
+
+enum weston_window_switcher_window_change {
+    WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_TITLE = (1 << 0),
+    WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_APP_ID = (1 << 1),
+    WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_GEOMETRY = (1 << 2),
+    WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_STATE = (1 << 3),
+    WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_OUTPUTS = (1 << 4),
+    WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_ALL = (1 << 5) - 1,
+};
+
+enum weston_window_switcher_window_dirty {
+    WESTON_WINDOW_SWITCHER_WINDOW_DIRTY_CONTENT = (1 << 0),
+    WESTON_WINDOW_SWITCHER_WINDOW_DIRTY_STRINGS = (1 << 1),
+};
+
+static uint32_t
+_weston_window_switcher_window_update_geometry(struct weston_window_switcher_window *self)
+{
+    struct weston_geometry geometry = weston_desktop_surface_get_geometry(self->surface);
+    uint32_t changes = 0, state = ZWW_WINDOW_SWITCHER_WINDOW_V1_STATE_MINIMIZED;
+    struct weston_view *view, *main_view = NULL;
+
+    wl_list_for_each(view, &self->wsurface->views, surface_link)
+    {
+        if ( ( ! weston_view_is_mapped(view) ) || _weston_window_switcher_view_is_ours(self->switcher, view) )
+            continue;
+        if ( main_view == NULL )
+            main_view = view;
+        if ( _weston_window_switcher_view_is_displayed(self->switcher, view) )
+        {
+            main_view = view;
+            state = 0;
+            break;
+        }
+    }
+
+    if ( main_view != NULL )
+    {
+        geometry.x += main_view->geometry.x;
+        geometry.y += main_view->geometry.y;
+    }
+
+    if ( weston_desktop_surface_get_activated(self->surface) )
+        state |= ZWW_WINDOW_SWITCHER_WINDOW_V1_STATE_ACTIVATED;
+    if ( weston_desktop_surface_get_maximized(self->surface) )
+        state |= ZWW_WINDOW_SWITCHER_WINDOW_V1_STATE_MAXIMIZED;
+    if ( weston_desktop_surface_get_fullscreen(self->surface) )
+        state |= ZWW_WINDOW_SWITCHER_WINDOW_V1_STATE_FULLSCREEN;
+
+    if ( ( geometry.x != self->geometry.x ) || ( geometry.y != self->geometry.y ) || ( geometry.width != self->geometry.width ) || ( geometry.height != self->geometry.height ) )
+        changes |= WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_GEOMETRY;
+    if ( state != self->state )
+        changes |= WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_STATE;
+    if ( self->wsurface->output_mask != self->output_mask )
+        changes |= WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_OUTPUTS;
+
+    self->geometry = geometry;
+    self->state = state;
+
+    return changes;
+}
+
+static void
+_weston_window_switcher_window_send_outputs(struct weston_window_switcher_window *self, struct wl_resource *resource, uint32_t mask, bool enter)
+{
+    struct wl_client *client = wl_resource_get_client(resource);
+    struct weston_output *output;
+    struct wl_resource *output_resource;
+
+    wl_list_for_each(output, &self->switcher->compositor->output_list, link)
+    {
+        if ( ( mask & ( 1u << output->id ) ) == 0 )
+            continue;
+
+        wl_resource_for_each(output_resource, &output->resource_list)
+        {
+            if ( wl_resource_get_client(output_resource) != client )
+                continue;
+            if ( enter )
+                zww_window_switcher_window_v1_send_output_enter(resource, output_resource);
+            else
+                zww_window_switcher_window_v1_send_output_leave(resource, output_resource);
+        }
+    }
+}
+
+/* Send the changed state, old_output_mask being what the resource knows */
+static void
+_weston_window_switcher_window_send_changes(struct weston_window_switcher_window *self, struct wl_resource *resource, uint32_t changes, uint32_t old_output_mask)
+{
+    if ( ( changes & WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_TITLE ) && ( self->title != NULL ) )
+        zww_window_switcher_window_v1_send_title(resource, self->title);
+    if ( ( changes & WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_APP_ID ) && ( self->app_id != NULL ) )
+        zww_window_switcher_window_v1_send_app_id(resource, self->app_id);
+
+    if ( wl_resource_get_version(resource) >= ZWW_WINDOW_SWITCHER_WINDOW_V1_GEOMETRY_SINCE_VERSION )
+    {
+        if ( changes & WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_GEOMETRY )
+            zww_window_switcher_window_v1_send_geometry(resource, self->geometry.x, self->geometry.y, self->geometry.width, self->geometry.height);
+        if ( changes & WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_STATE )
+            zww_window_switcher_window_v1_send_state(resource, self->state);
+        if ( changes & WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_OUTPUTS )
+        {
+            _weston_window_switcher_window_send_outputs(self, resource, old_output_mask & ~self->output_mask, false);
+            _weston_window_switcher_window_send_outputs(self, resource, self->output_mask & ~old_output_mask, true);
+        }
+    }
+}
+
+static void
+_weston_window_switcher_window_announce(struct weston_window_switcher_window *self, struct weston_window_switcher_client *client)
+{
+    struct wl_client *wclient = wl_resource_get_client(client->resource);
+    struct wl_resource *resource;
+
+    resource = wl_resource_create(wclient, &zww_window_switcher_window_v1_interface, wl_resource_get_version(client->resource), 0);
+    if ( resource == NULL )
+    {
+        wl_client_post_no_memory(wclient);
+        return;
+    }
+
+    wl_resource_set_implementation(resource, &weston_window_switcher_window_implementation, self, _weston_window_switcher_window_destroy);
+    wl_list_insert(&self->resources, wl_resource_get_link(resource));
+
+    zww_window_switcher_v1_send_window(client->resource, resource);
+
+    _weston_window_switcher_window_send_mru_rank(self, resource);
+    _weston_window_switcher_window_send_changes(self, resource, WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_ALL, 0);
+    zww_window_switcher_window_v1_send_done(resource);
+}
+
+static void
+_weston_window_switcher_window_announce_all(struct weston_window_switcher_window *self)
+{
+    struct weston_window_switcher_client *client;
+
+    _weston_window_switcher_update_string(&self->title, weston_desktop_surface_get_title(self->surface));
+    _weston_window_switcher_update_string(&self->app_id, weston_desktop_surface_get_app_id(self->surface));
+    _weston_window_switcher_window_update_geometry(self);
+    self->output_mask = self->wsurface->output_mask;
+
+    if ( self->switcher->search != NULL )
+        self->search_document = weston_window_switcher_search_add(self->switcher->search, self);
+    if ( self->search_document != NULL )
+        weston_window_switcher_search_update(self->switcher->search, self->search_document, self->title, self->app_id);
+
+    wl_list_for_each(client, &self->switcher->clients, link)
+    {
+        if ( ( ! client->paged ) && ( client->announce_idle == NULL ) )
+            _weston_window_switcher_window_announce(self, client);
+    }
+}
+
+static bool
+_weston_window_switcher_surface_is_mapped(struct weston_surface *surface)
+{
+    struct weston_view *view;
+
+    wl_list_for_each(view, &surface->views, surface_link)
+    {
+        if ( weston_view_is_mapped(view) )
+            return true;
+    }
+
+    return false;
+}
+
+static bool
+_weston_window_switcher_surface_is_focused(struct weston_window_switcher *switcher, struct weston_surface *surface)
+{
+    struct weston_window_switcher_seat *seat;
+
+    wl_list_for_each(seat, &switcher->seats, link)
+    {
+        if ( ( seat->keyboard != NULL ) && ( seat->keyboard->focus != NULL ) && ( weston_surface_get_main_surface(seat->keyboard->focus) == surface ) )
+            return true;
+    }
+
+    return false;
+}
+
+/* A pending window becomes a window once mapped, and is dropped if it lost its desktop surface */
+static void
+_weston_window_switcher_window_map(struct weston_window_switcher_window *self)
+{
+    struct weston_window_switcher *switcher = self->switcher;
+    struct weston_desktop_surface *dsurface = weston_surface_get_desktop_surface(self->wsurface);
+
+    if ( dsurface == NULL )
+    {
+        _weston_window_switcher_window_free(self);
+        return;
+    }
+
+    if ( ! _weston_window_switcher_surface_is_mapped(self->wsurface) )
+        return;
+
+    self->surface = dsurface;
+    self->mru_rank = UINT32_MAX;
+    wl_list_remove(&self->link);
+
+    /* A window may already have the focus when we notice its mapping */
+    if ( _weston_window_switcher_surface_is_focused(switcher, self->wsurface) )
+        wl_list_insert(&switcher->windows, &self->link);
+    else
+        wl_list_insert(switcher->windows.prev, &self->link);
+    _weston_window_switcher_renumber(switcher, &self->link);
+    _weston_window_switcher_update_count(switcher, 1);
+
+    _weston_window_switcher_window_announce_all(self);
+}
+
+/* Compare the window state against our copy and only send the changed parts, in a single group */
+static void
+_weston_window_switcher_window_update(struct weston_window_switcher_window *self, uint32_t dirty)
+{
+    uint32_t changes = 0, old_output_mask = self->output_mask;
+
+    /* A window that lost its desktop surface is pending again */
+    if ( self->surface != NULL )
+        _weston_window_switcher_window_check(self);
+    if ( self->surface == NULL )
+    {
+        _weston_window_switcher_window_map(self);
+        return;
+    }
+
+    if ( dirty & WESTON_WINDOW_SWITCHER_WINDOW_DIRTY_CONTENT )
+    {
+        changes = _weston_window_switcher_window_update_geometry(self);
+        self->output_mask = self->wsurface->output_mask;
+    }
+
+    if ( dirty & WESTON_WINDOW_SWITCHER_WINDOW_DIRTY_STRINGS )
+    {
+        if ( _weston_window_switcher_update_string(&self->title, weston_desktop_surface_get_title(self->surface)) )
+            changes |= WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_TITLE;
+        if ( _weston_window_switcher_update_string(&self->app_id, weston_desktop_surface_get_app_id(self->surface)) )
+            changes |= WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_APP_ID;
+    }
+
+    if ( changes == 0 )
+        return;
+
+    if ( ( changes & ( WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_TITLE | WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_APP_ID ) ) && ( self->search_document != NULL ) )
+        weston_window_switcher_search_update(self->switcher->search, self->search_document, self->title, self->app_id);
+
+    struct wl_resource *resource;
+    wl_resource_for_each(resource, &self->resources)
+    {
+        if ( ( wl_resource_get_version(resource) < ZWW_WINDOW_SWITCHER_WINDOW_V1_GEOMETRY_SINCE_VERSION ) && ( ( changes & ( WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_TITLE | WESTON_WINDOW_SWITCHER_WINDOW_CHANGE_APP_ID ) ) == 0 ) )
+            continue;
+        _weston_window_switcher_window_send_changes(self, resource, changes, old_output_mask);
+        zww_window_switcher_window_v1_send_done(resource);
+    }
+}
+
+static void
+_weston_window_switcher_window_mark(struct weston_window_switcher_window *self, uint32_t dirty)
+{
+    if ( self->dirty == 0 )
+        wl_list_insert(self->switcher->dirty.prev, &self->dirty_link);
+    self->dirty |= dirty;
+}
+
+/*
+ * Only the windows marked dirty are looked at, once per repaint
+ * Title and app_id are checked at most once per title-interval, windows
+ * waiting for it stay marked and a timer makes sure they are handled
+ */
+static void
+_weston_window_switcher_update(struct weston_window_switcher *switcher)
+{
+    struct weston_window_switcher_window *self, *tmp;
+    uint32_t now = _weston_window_switcher_get_time();
+    bool strings = ( ( now - switcher->title_time ) >= switcher->title_interval );
+    bool strings_pending = false, strings_done = false;
+
+    if ( switcher->previews_dirty )
+        _weston_window_switcher_update_previews(switcher);
+    switcher->previews_dirty = false;
+
+    wl_list_for_each_safe(self, tmp, &switcher->dirty, dirty_link)
+    {
+        uint32_t dirty = self->dirty;
+
+        if ( ! strings )
+            dirty &= ~WESTON_WINDOW_SWITCHER_WINDOW_DIRTY_STRINGS;
+        strings_done = strings_done || ( dirty & WESTON_WINDOW_SWITCHER_WINDOW_DIRTY_STRINGS );
+
+        self->dirty &= ~dirty;
+        if ( self->dirty != 0 )
+            strings_pending = true;
+        else
+        {
+            wl_list_remove(&self->dirty_link);
+            wl_list_init(&self->dirty_link);
+        }
+
+        if ( dirty != 0 )
+            _weston_window_switcher_window_update(self, dirty);
+    }
+
+    if ( strings_done )
+        switcher->title_time = now;
+    if ( strings_pending )
+        wl_event_source_timer_update(switcher->title_timer, MAX(1, (int32_t) ( switcher->title_interval - ( now - switcher->title_time ) )));
+}
+
+static int
+_weston_window_switcher_title_timeout(void *data)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher *switcher = data;
+
+    _weston_window_switcher_update(switcher);
+
+    return 0;
+}
+
+/*
+ * A commit may change anything in the window state, it is only marked
+ * here and looked at on the next repaint
+ * Title and app_id changes are picked up with the commit following them,
+ * as are moves done by the shell alone
+ */
+static void
+_weston_window_switcher_window_surface_committed(struct wl_listener *listener, void *data)
+{
+    struct weston_window_switcher_window *self = wl_container_of(listener, self, surface_commit_listener);
+
+    ++self->commits;
+    _weston_window_switcher_window_mark(self, WESTON_WINDOW_SWITCHER_WINDOW_DIRTY_CONTENT | WESTON_WINDOW_SWITCHER_WINDOW_DIRTY_STRINGS);
+
+    /* The previews follow the windows size */
+    if ( ! wl_list_empty(&self->switcher->previews) )
+        self->switcher->previews_dirty = true;
+}
+
+/*
+ * Desktop surfaces are tracked from their first commit, the role being set
+ * before that
+ * They wait in the pending list until mapped
+ */
+static struct weston_window_switcher_window *
+_weston_window_switcher_track_surface(struct weston_window_switcher *switcher, struct weston_surface *surface)
+{
+    struct weston_window_switcher_window *self;
+
+    self = _weston_window_switcher_window_from_surface(surface);
+    if ( self != NULL )
+        return self;
+
+    if ( weston_surface_get_desktop_surface(surface) == NULL )
+        return NULL;
+
+    self = zalloc(sizeof(struct weston_window_switcher_window));
+    if ( self == NULL )
+        return NULL;
+
+    self->switcher = switcher;
+    self->wsurface = surface;
+    wl_list_init(&self->resources);
+    wl_list_init(&self->dirty_link);
+
+    self->surface_destroy_listener.notify = _weston_window_switcher_window_surface_destroyed;
+    self->surface_commit_listener.notify = _weston_window_switcher_window_surface_committed;
+    wl_signal_add(&surface->destroy_signal, &self->surface_destroy_listener);
+    wl_signal_add(&surface->commit_signal, &self->surface_commit_listener);
+
+    wl_list_insert(&switcher->pending, &self->link);
+
+    return self;
+}
+
+/*
+ * New surfaces are watched until they commit with a role, other roles
+ * are then left alone
+ */
+struct weston_window_switcher_surface {
+    struct weston_window_switcher *switcher;
+    struct weston_surface *surface;
+    struct wl_listener commit_listener;
+    struct wl_listener destroy_listener;
+};
+
+static void
+_weston_window_switcher_surface_free(struct weston_window_switcher_surface *self)
+{
+    wl_list_remove(&self->commit_listener.link);
+    wl_list_remove(&self->destroy_listener.link);
+
+    free(self);
+}
+
+static void
+_weston_window_switcher_surface_committed(struct wl_listener *listener, void *data)
+{
+    struct weston_window_switcher_surface *self = wl_container_of(listener, self, commit_listener);
+    struct weston_window_switcher_window *window;
+
+    if ( self->surface->role_name == NULL )
+        return;
+
+    window = _weston_window_switcher_track_surface(self->switcher, self->surface);
+    if ( window != NULL )
+        _weston_window_switcher_window_surface_committed(&window->surface_commit_listener, self->surface);
+
+    _weston_window_switcher_surface_free(self);
+}
+
+static void
+_weston_window_switcher_surface_destroyed(struct wl_listener *listener, void *data)
+{
+    struct weston_window_switcher_surface *self = wl_container_of(listener, self, destroy_listener);
+
+    _weston_window_switcher_surface_free(self);
+}
+
+static void
+_weston_window_switcher_surface_created(struct wl_listener *listener, void *data)
+{
+    struct weston_window_switcher *switcher = wl_container_of(listener, switcher, create_surface_listener);
+    struct weston_surface *surface = data;
+    struct weston_window_switcher_surface *self;
+
+    self = zalloc(sizeof(struct weston_window_switcher_surface));
+    if ( self == NULL )
+        return;
+
+    self->switcher = switcher;
+    self->surface = surface;
+
+    self->commit_listener.notify = _weston_window_switcher_surface_committed;
+    self->destroy_listener.notify = _weston_window_switcher_surface_destroyed;
+    wl_signal_add(&surface->commit_signal, &self->commit_listener);
+    wl_signal_add(&surface->destroy_signal, &self->destroy_listener);
+}
+
+static void
+_weston_window_switcher_seat_keyboard_focus(struct wl_listener *listener, void *data)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_seat *self = wl_container_of(listener, self, keyboard_focus_listener);
+    struct weston_window_switcher *switcher = self->switcher;
+    struct weston_keyboard *keyboard = data;
+    struct weston_window_switcher_window *window;
+
+    /* The shell may have restacked the previews hosts */
+    switcher->previews_dirty = true;
+
+    if ( keyboard->focus == NULL )
+        return;
+
+    window = _weston_window_switcher_window_from_surface(weston_surface_get_main_surface(keyboard->focus));
+    if ( window != NULL )
+        _weston_window_switcher_window_set_most_recent(window);
+}
+
+/*
+ * The default grabs are wrapped to pick views through the previews, as
+ * those are views of other clients' surfaces which must not get input
+ */
+static void
+_weston_window_switcher_seat_pointer_focus(struct weston_pointer_grab *grab)
+{
+    struct weston_window_switcher_seat *self = wl_container_of(grab->interface, self, pointer.interface);
+    struct weston_pointer *pointer = grab->pointer;
     struct weston_view *view;
-    struct wl_listener surface_destroy_listener;
-    struct wl_listener view_destroy_listener;
-};
+    wl_fixed_t sx, sy;
+
+    if ( wl_list_empty(&self->switcher->previews) )
+    {
+        self->pointer.parent->focus(grab);
+        return;
+    }
+
+    if ( pointer->button_count > 0 )
+        return;
+
+    view = _weston_window_switcher_pick_view(self->switcher, pointer->x, pointer->y, &sx, &sy);
+
+    if ( ( pointer->focus != view ) || ( pointer->sx != sx ) || ( pointer->sy != sy ) )
+        weston_pointer_set_focus(pointer, view, sx, sy);
+}
 
 static void
-_weston_window_switcher_request_destroy(struct wl_client *client, struct wl_resource *resource)
+_weston_window_switcher_seat_touch_down(struct weston_touch_grab *grab, uint32_t time, int touch_id, wl_fixed_t x, wl_fixed_t y)
 {
-    wl_resource_destroy(resource);
+    struct weston_window_switcher_seat *self = wl_container_of(grab->interface, self, touch.interface);
+    struct weston_touch *touch = grab->touch;
+    wl_fixed_t sx, sy;
+
+    if ( ( touch->focus != NULL ) && _weston_window_switcher_view_is_preview(touch->focus) )
+        weston_touch_set_focus(touch, _weston_window_switcher_pick_view(self->switcher, x, y, &sx, &sy));
+
+    self->touch.parent->down(grab, time, touch_id, x, y);
 }
 
 static void
-_weston_window_switcher_window_surface_destroyed(struct wl_listener *listener, void *data)
+_weston_window_switcher_seat_caps(struct wl_listener *listener, void *data)
 {
-    struct weston_window_switcher_window *self = wl_container_of(listener, self, surface_destroy_listener);
+    struct weston_window_switcher_seat *self = wl_container_of(listener, self, caps_listener);
+    struct weston_keyboard *keyboard = weston_seat_get_keyboard(self->seat);
+    struct weston_pointer *pointer = weston_seat_get_pointer(self->seat);
+    struct weston_touch *touch = weston_seat_get_touch(self->seat);
 
-    self->surface = NULL;
+    /* The input device objects live as long as the seat once created */
+    if ( ( pointer != NULL ) && ( self->pointer.parent == NULL ) )
+    {
+        self->pointer.parent = pointer->default_grab.interface;
+        self->pointer.interface = *self->pointer.parent;
+        self->pointer.interface.focus = _weston_window_switcher_seat_pointer_focus;
+        pointer->default_grab.interface = &self->pointer.interface;
+    }
+
+    if ( ( touch != NULL ) && ( self->touch.parent == NULL ) )
+    {
+        self->touch.parent = touch->default_grab.interface;
+        self->touch.interface = *self->touch.parent;
+        self->touch.interface.down = _weston_window_switcher_seat_touch_down;
+        touch->default_grab.interface = &self->touch.interface;
+    }
+
+    if ( ( keyboard == NULL ) || ( self->keyboard != NULL ) )
+        return;
+
+    self->keyboard = keyboard;
+    self->keyboard_focus_listener.notify = _weston_window_switcher_seat_keyboard_focus;
+    wl_signal_add(&self->keyboard->focus_signal, &self->keyboard_focus_listener);
 }
 
 static void
-_weston_window_switcher_window_view_destroyed(struct wl_listener *listener, void *data)
+_weston_window_switcher_seat_destroyed(struct wl_listener *listener, void *data)
 {
-    struct weston_window_switcher_window  *self = wl_container_of(listener, self, view_destroy_listener);
+    struct weston_window_switcher_seat *self = wl_container_of(listener, self, seat_destroy_listener);
 
-    weston_view_damage_below(self->view);
-    self->view = NULL;
+    /*
+     * The keyboard, and its grab, are already gone, and its focus signal
+     * with them, so our listener must not be unlinked from it
+     */
+    if ( self->cycle.view != NULL )
+        weston_view_destroy(self->cycle.view);
+    self->keyboard = NULL;
+    wl_list_remove(&self->caps_listener.link);
+    wl_list_remove(&self->seat_destroy_listener.link);
+    wl_list_remove(&self->link);
+
+    free(self);
 }
 
 static void
-_weston_window_switcher_window_destroy(struct wl_resource *resource)
+_weston_window_switcher_seat_add(struct weston_window_switcher *switcher, struct weston_seat *seat)
 {
-    struct weston_window_switcher *self = wl_resource_get_user_data(resource);
+    struct weston_window_switcher_seat *self;
+
+    self = zalloc(sizeof(struct weston_window_switcher_seat));
+    if ( self == NULL )
+        return;
+
+    self->switcher = switcher;
+    self->seat = seat;
+
+    self->seat_destroy_listener.notify = _weston_window_switcher_seat_destroyed;
+    self->caps_listener.notify = _weston_window_switcher_seat_caps;
+    wl_signal_add(&seat->destroy_signal, &self->seat_destroy_listener);
+    wl_signal_add(&seat->updated_caps_signal, &self->caps_listener);
 
-    self->binding = NULL;
+    wl_list_insert(&switcher->seats, &self->link);
+
+    _weston_window_switcher_seat_caps(&self->caps_listener, seat);
 }
 
+/*
+ * The cycling grab steps through the MRU list while its modifier is held,
+ * previewing the candidate above the other windows and only telling the
+ * clients its index, focus is committed when the modifier is released
+ */
 static void
-_weston_window_switcher_window_request_switch_to(struct wl_client *client, struct wl_resource *resource, struct wl_resource *seat_resource, uint32_t serial)
+_weston_window_switcher_seat_cycle_select(struct weston_window_switcher_seat *self, struct weston_window_switcher_window *window)
 {
-    struct weston_window_switcher_window *self = wl_resource_get_user_data(resource);
-    struct weston_surface *surface = weston_desktop_surface_get_surface(self->surface);
-    struct weston_seat *seat = wl_resource_get_user_data(seat_resource);
-    struct weston_keyboard *keyboard = weston_seat_get_keyboard(seat);
-    struct weston_pointer *pointer = weston_seat_get_pointer(seat);
-    struct weston_touch *touch = weston_seat_get_touch(seat);
+    struct weston_window_switcher *switcher = self->switcher;
+    struct weston_view *view;
+
+    if ( self->cycle.view != NULL )
+        weston_view_destroy(self->cycle.view);
+    self->cycle.view = NULL;
+    self->cycle.window = window;
+
+    wl_list_for_each(view, &window->wsurface->views, surface_link)
+    {
+        if ( ( ! weston_view_is_mapped(view) ) || _weston_window_switcher_view_is_ours(switcher, view) )
+            continue;
+
+        self->cycle.view = weston_view_create(window->wsurface);
+        if ( self->cycle.view == NULL )
+            break;
+
+        weston_layer_entry_insert(&switcher->layer.view_list, &self->cycle.view->layer_link);
+        self->cycle.view->is_mapped = true;
+        weston_view_set_position(self->cycle.view, view->geometry.x, view->geometry.y);
+        weston_view_update_transform(self->cycle.view);
+        break;
+    }
+    weston_compositor_schedule_repaint(switcher->compositor);
 
-    if ( keyboard == NULL )
+    struct weston_window_switcher_client *client;
+    wl_list_for_each(client, &switcher->clients, link)
+    {
+        if ( wl_resource_get_version(client->resource) >= ZWW_WINDOW_SWITCHER_V1_SELECTED_SINCE_VERSION )
+            zww_window_switcher_v1_send_selected(client->resource, window->mru_rank);
+    }
+}
+
+static void
+_weston_window_switcher_seat_cycle_end(struct weston_window_switcher_seat *self, bool commit)
+{
+    struct weston_window_switcher_window *window = self->cycle.window;
+
+    if ( window == NULL )
         return;
 
-    if ( ( keyboard != NULL ) && ( keyboard->grab_serial == serial ) )
-        weston_keyboard_set_focus(keyboard, surface);
-    else if ( ( pointer != NULL ) && ( pointer->grab_serial == serial ) )
-        weston_keyboard_set_focus(keyboard, surface);
-    else if ( ( touch != NULL ) && ( touch->grab_serial == serial ) )
-        weston_keyboard_set_focus(keyboard, surface);
+    if ( self->cycle.view != NULL )
+    {
+        weston_view_destroy(self->cycle.view);
+        weston_compositor_schedule_repaint(self->switcher->compositor);
+    }
+    self->cycle.view = NULL;
+    self->cycle.window = NULL;
+
+    weston_keyboard_end_grab(self->keyboard);
+
+    if ( commit && _weston_window_switcher_window_check(window) )
+        _weston_window_switcher_window_activate(window, self->seat);
+
+    ww_stats_add(commit ? &self->switcher->stats.cycles_committed : &self->switcher->stats.cycles_cancelled, 1);
 }
 
 static void
-_weston_window_switcher_window_request_close(struct wl_client *client, struct wl_resource *resource, struct wl_resource *seat_resource, uint32_t serial)
+_weston_window_switcher_seat_cycle_key(struct weston_keyboard_grab *grab, uint32_t time, uint32_t key, enum wl_keyboard_key_state state)
 {
-    struct weston_window_switcher_window *self = wl_resource_get_user_data(resource);
-    struct weston_seat *seat = wl_resource_get_user_data(seat_resource);
-    struct weston_keyboard *keyboard = weston_seat_get_keyboard(seat);
-    struct weston_pointer *pointer = weston_seat_get_pointer(seat);
-    struct weston_touch *touch = weston_seat_get_touch(seat);
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_seat *self = wl_container_of(grab, self, cycle.grab);
+    struct wl_list *head = &self->switcher->windows;
+    struct weston_window_switcher_window *window;
+    struct wl_list *link;
 
-    if ( keyboard == NULL )
+    /* Only Tab and Escape are ours, the focused client gets the other keys */
+    if ( ( key != KEY_TAB ) && ( key != KEY_ESC ) )
+    {
+        weston_keyboard_send_key(grab->keyboard, time, key, state);
         return;
+    }
 
-    if ( ( keyboard != NULL ) && ( keyboard->grab_serial == serial ) )
-        weston_desktop_surface_close(self->surface);
-    else if ( ( pointer != NULL ) && ( pointer->grab_serial == serial ) )
-        weston_desktop_surface_close(self->surface);
-    else if ( ( touch != NULL ) && ( touch->grab_serial == serial ) )
-        weston_desktop_surface_close(self->surface);
+    if ( state != WL_KEYBOARD_KEY_STATE_PRESSED )
+        return;
+
+    switch ( key )
+    {
+    case KEY_TAB:
+        if ( self->seat->modifier_state & MODIFIER_SHIFT )
+            link = ( self->cycle.window->link.prev != head ) ? self->cycle.window->link.prev : head->prev;
+        else
+            link = ( self->cycle.window->link.next != head ) ? self->cycle.window->link.next : head->next;
+        _weston_window_switcher_seat_cycle_select(self, wl_container_of(link, window, link));
+    break;
+    case KEY_ESC:
+        _weston_window_switcher_seat_cycle_end(self, false);
+    break;
+    }
 }
 
 static void
-_weston_window_switcher_window_request_show(struct wl_client *client, struct wl_resource *resource, struct wl_resource *surface, int32_t x, int32_t y, int32_t width, int32_t height)
+_weston_window_switcher_seat_cycle_modifiers(struct weston_keyboard_grab *grab, uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group)
 {
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_seat *self = wl_container_of(grab, self, cycle.grab);
+
+    weston_keyboard_send_modifiers(grab->keyboard, serial, mods_depressed, mods_latched, mods_locked, group);
 
+    if ( ( self->seat->modifier_state & self->switcher->cycle_modifier ) == 0 )
+        _weston_window_switcher_seat_cycle_end(self, true);
 }
 
-static const struct zww_window_switcher_window_v1_interface weston_window_switcher_window_implementation = {
-    .destroy = _weston_window_switcher_request_destroy,
-    .switch_to = _weston_window_switcher_window_request_switch_to,
-    .close = _weston_window_switcher_window_request_close,
-    .show = _weston_window_switcher_window_request_show,
+static void
+_weston_window_switcher_seat_cycle_cancel(struct weston_keyboard_grab *grab)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_seat *self = wl_container_of(grab, self, cycle.grab);
+
+    _weston_window_switcher_seat_cycle_end(self, false);
+}
+
+static const struct weston_keyboard_grab_interface _weston_window_switcher_seat_cycle_interface = {
+    .key = _weston_window_switcher_seat_cycle_key,
+    .modifiers = _weston_window_switcher_seat_cycle_modifiers,
+    .cancel = _weston_window_switcher_seat_cycle_cancel,
 };
 
 static void
-_weston_window_switcher_window_create(struct weston_window_switcher *switcher, struct weston_surface *surface)
+_weston_window_switcher_cycle_binding(struct weston_keyboard *keyboard, uint32_t time, uint32_t key, void *data)
 {
-    struct weston_window_switcher_window  *self;
-    struct weston_desktop_surface *dsurface = weston_surface_get_desktop_surface(surface);
+    WW_TRACE_SCOPE();
 
-    if ( dsurface == NULL )
+    struct weston_window_switcher *switcher = data;
+    struct weston_window_switcher_seat *self;
+    struct weston_window_switcher_window *window;
+    struct wl_listener *listener;
+
+    if ( wl_list_empty(&switcher->windows) || ( keyboard->grab != &keyboard->default_grab ) )
+        return;
+
+    listener = wl_signal_get(&keyboard->seat->destroy_signal, _weston_window_switcher_seat_destroyed);
+    if ( listener == NULL )
+        return;
+    self = wl_container_of(listener, self, seat_destroy_listener);
+
+    /* The first window is the focused one, start on the previous one */
+    window = wl_container_of(switcher->windows.next, window, link);
+    if ( window->link.next != &switcher->windows )
+        window = wl_container_of(window->link.next, window, link);
+
+    self->cycle.grab.interface = &_weston_window_switcher_seat_cycle_interface;
+    weston_keyboard_start_grab(keyboard, &self->cycle.grab);
+    _weston_window_switcher_seat_cycle_select(self, window);
+    ww_stats_add(&switcher->stats.cycles_started, 1);
+}
+
+static void
+_weston_window_switcher_seat_created(struct wl_listener *listener, void *data)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher *switcher = wl_container_of(listener, switcher, seat_created_listener);
+    struct weston_seat *seat = data;
+
+    _weston_window_switcher_seat_add(switcher, seat);
+}
+
+static void
+_weston_window_switcher_output_frame(struct wl_listener *listener, void *data)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_output *self = wl_container_of(listener, self, frame_listener);
+    struct weston_window_switcher *switcher = self->switcher;
+
+    /* The first output done repainting handles everything */
+    if ( wl_list_empty(&switcher->dirty) && ( ! switcher->previews_dirty ) )
+        return;
+
+    /* Keep the state current even unbound, for the search index and new clients */
+    uint64_t start = ww_stats_start();
+    _weston_window_switcher_update(switcher);
+    ww_stats_stop(&switcher->stats.update, start);
+}
+
+static void
+_weston_window_switcher_output_add(struct weston_window_switcher *switcher, struct weston_output *woutput)
+{
+    struct weston_window_switcher_output *self;
+
+    self = zalloc(sizeof(struct weston_window_switcher_output));
+    if ( self == NULL )
         return;
 
-    wl_list_for_each(self, &switcher->windows, link)
+    self->switcher = switcher;
+    self->output = woutput;
+
+    self->frame_listener.notify = _weston_window_switcher_output_frame;
+    wl_signal_add(&woutput->frame_signal, &self->frame_listener);
+
+    wl_list_insert(&switcher->outputs, &self->link);
+}
+
+static void
+_weston_window_switcher_output_created(struct wl_listener *listener, void *data)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher *switcher = wl_container_of(listener, switcher, output_created_listener);
+    struct weston_output *woutput = data;
+
+    _weston_window_switcher_output_add(switcher, woutput);
+}
+
+static void
+_weston_window_switcher_output_destroyed(struct wl_listener *listener, void *data)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher *switcher = wl_container_of(listener, switcher, output_destroyed_listener);
+    struct weston_output *woutput = data;
+    struct weston_window_switcher_output *self;
+
+    wl_list_for_each(self, &switcher->outputs, link)
     {
-        if ( self->surface == dsurface )
-            return;
+        if ( self->output != woutput )
+            continue;
+
+        wl_list_remove(&self->frame_listener.link);
+        wl_list_remove(&self->link);
+        free(self);
+        return;
     }
+}
 
-    self = zalloc(sizeof(struct weston_window_switcher_window));
-    if ( self == NULL )
+static void
+_weston_window_switcher_request_set_paged(struct wl_client *client, struct wl_resource *resource)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_client *self = wl_resource_get_user_data(resource);
+
+    if ( self->paged )
+        return;
+
+    self->paged = true;
+    zww_window_switcher_v1_send_count(self->resource, self->switcher->window_count);
+}
+
+static bool
+_weston_window_switcher_window_has_client(struct weston_window_switcher_window *self, struct wl_client *client)
+{
+    struct wl_resource *resource;
+
+    wl_resource_for_each(resource, &self->resources)
     {
-        wl_client_post_no_memory(switcher->client);
+        if ( wl_resource_get_client(resource) == client )
+            return true;
+    }
+
+    return false;
+}
+
+/* Announce the windows of a MRU range the client does not know yet */
+static void
+_weston_window_switcher_request_get_windows(struct wl_client *client, struct wl_resource *resource, uint32_t first, uint32_t count)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_client *self = wl_resource_get_user_data(resource);
+    struct weston_window_switcher *switcher = self->switcher;
+    struct wl_list *link = switcher->windows.next;
+    struct weston_window_switcher_window *window;
+    uint32_t i;
+
+    if ( ( ! self->paged ) || ( first >= switcher->window_count ) )
         return;
+
+    for ( i = 0 ; i < first ; ++i )
+        link = link->next;
+
+    for ( i = 0 ; ( i < count ) && ( link != &switcher->windows ) ; ++i, link = link->next )
+    {
+        window = wl_container_of(link, window, link);
+        if ( ! _weston_window_switcher_window_has_client(window, client) )
+            _weston_window_switcher_window_announce(window, self);
     }
+}
 
-    self->switcher = switcher;
-    self->surface = dsurface;
+static void _weston_window_switcher_client_announce(void *data);
 
-    self->resource = wl_resource_create(switcher->client, &zww_window_switcher_window_v1_interface, wl_resource_get_version(switcher->binding), 0);
-    if ( self->resource == NULL )
+static void
+_weston_window_switcher_search_result(void *document_data, void *data)
+{
+    struct weston_window_switcher_window *window = document_data;
+    struct weston_window_switcher_client *self = data;
+    struct wl_client *client = wl_resource_get_client(self->resource);
+    struct wl_resource *resource;
+
+    wl_resource_for_each(resource, &window->resources)
     {
-        wl_client_post_no_memory(switcher->client);
+        if ( wl_resource_get_client(resource) == client )
+        {
+            zww_window_switcher_v1_send_search_result(self->resource, resource);
+            return;
+        }
+    }
+
+    /* Paged clients only know the windows they asked for */
+    _weston_window_switcher_window_announce(window, self);
+    if ( wl_list_empty(&window->resources) )
         return;
+    resource = wl_resource_from_link(window->resources.next);
+    if ( wl_resource_get_client(resource) == client )
+        zww_window_switcher_v1_send_search_result(self->resource, resource);
+}
+
+/* The index is only kept while a client uses search */
+static bool
+_weston_window_switcher_search_enable(struct weston_window_switcher *self)
+{
+    struct weston_window_switcher_window *window;
+
+    if ( self->search != NULL )
+        return true;
+
+    self->search = weston_window_switcher_search_new();
+    if ( self->search == NULL )
+        return false;
+
+    wl_list_for_each(window, &self->windows, link)
+    {
+        window->search_document = weston_window_switcher_search_add(self->search, window);
+        if ( window->search_document != NULL )
+            weston_window_switcher_search_update(self->search, window->search_document, window->title, window->app_id);
     }
 
-    self->surface_destroy_listener.notify = _weston_window_switcher_window_surface_destroyed;
-    wl_signal_add(&surface->destroy_signal, &self->surface_destroy_listener);
-    wl_resource_set_implementation(self->resource, &weston_window_switcher_window_implementation, self, _weston_window_switcher_window_destroy);
+    return true;
+}
+
+static void
+_weston_window_switcher_search_disable(struct weston_window_switcher *self)
+{
+    struct weston_window_switcher_window *window;
+    struct weston_window_switcher_client *client;
+
+    if ( self->search == NULL )
+        return;
+
+    wl_list_for_each(client, &self->clients, link)
+    {
+        if ( client->searched )
+            return;
+    }
+
+    wl_list_for_each(window, &self->windows, link)
+        window->search_document = NULL;
+    wl_list_for_each(window, &self->pending, link)
+        window->search_document = NULL;
+
+    weston_window_switcher_search_free(self->search);
+    self->search = NULL;
+}
+
+static void
+_weston_window_switcher_request_search(struct wl_client *client, struct wl_resource *resource, const char *query)
+{
+    WW_TRACE_SCOPE();
+
+    struct weston_window_switcher_client *self = wl_resource_get_user_data(resource);
+
+    if ( self->announce_idle != NULL )
+    {
+        wl_event_source_remove(self->announce_idle);
+        _weston_window_switcher_client_announce(self);
+    }
 
-    zww_window_switcher_v1_send_window(switcher->binding, self->resource);
+    if ( ! _weston_window_switcher_search_enable(self->switcher) )
+    {
+        wl_client_post_no_memory(client);
+        return;
+    }
+    self->searched = true;
 
-    const char *title = weston_desktop_surface_get_title(self->surface);
-    if ( title != NULL )
-        zww_window_switcher_window_v1_send_title(self->resource, title);
-    const char *app_id = weston_desktop_surface_get_app_id(self->surface);
-    if ( app_id != NULL )
-        zww_window_switcher_window_v1_send_app_id(self->resource, app_id);
-    zww_window_switcher_window_v1_send_done(self->resource);
+    uint64_t start = ww_stats_start();
+    weston_window_switcher_search_query(self->switcher->search, query, _weston_window_switcher_search_result, self);
+    ww_stats_stop(&self->switcher->stats.search, start);
+    zww_window_switcher_v1_send_search_done(self->resource);
 }
 
 static const struct zww_window_switcher_v1_interface weston_window_switcher_implementation = {
     .destroy = _weston_window_switcher_request_destroy,
+    .set_paged = _weston_window_switcher_request_set_paged,
+    .get_windows = _weston_window_switcher_request_get_windows,
+    .search = _weston_window_switcher_request_search,
 };
 
 static void
 _weston_window_switcher_unbind(struct wl_resource *resource)
 {
-    struct weston_window_switcher *self = wl_resource_get_user_data(resource);
+    struct weston_window_switcher_client *self = wl_resource_get_user_data(resource);
+
+    if ( self->announce_idle != NULL )
+        wl_event_source_remove(self->announce_idle);
+    wl_list_remove(&self->link);
+
+    if ( self->searched )
+        _weston_window_switcher_search_disable(self->switcher);
+
+    free(self);
+}
+
+static void
+_weston_window_switcher_client_announce(void *data)
+{
+    struct weston_window_switcher_client *self = data;
+    struct weston_window_switcher_window *window;
+
+    self->announce_idle = NULL;
 
-    self->binding = NULL;
+    if ( self->paged )
+        return;
+
+    wl_list_for_each(window, &self->switcher->windows, link)
+        _weston_window_switcher_window_announce(window, self);
 }
 
 static void
 _weston_window_switcher_bind(struct wl_client *client, void *data, uint32_t version, uint32_t id)
 {
-    struct weston_window_switcher *self = data;
-    struct wl_resource *resource;
+    WW_TRACE_SCOPE();
 
-    resource = wl_resource_create(client, &zww_window_switcher_v1_interface, version, id);
-    wl_resource_set_implementation(resource, &weston_window_switcher_implementation, self, _weston_window_switcher_unbind);
+    struct weston_window_switcher *switcher = data;
+    struct weston_window_switcher_client *self;
 
-    if ( self->binding != NULL )
+    self = zalloc(sizeof(struct weston_window_switcher_client));
+    if ( self == NULL )
     {
-        wl_resource_post_error(resource, ZWW_WINDOW_SWITCHER_V1_ERROR_BOUND, "interface object already bound");
-        wl_resource_destroy(resource);
+        wl_client_post_no_memory(client);
         return;
     }
 
-    self->client = client;
-    self->binding = resource;
+    self->switcher = switcher;
 
-    struct weston_view *view;
-    wl_list_for_each(view, &self->compositor->view_list, link)
-        _weston_window_switcher_window_create(self, view->surface);
+    self->resource = wl_resource_create(client, &zww_window_switcher_v1_interface, version, id);
+    if ( self->resource == NULL )
+    {
+        free(self);
+        wl_client_post_no_memory(client);
+        return;
+    }
+    wl_resource_set_implementation(self->resource, &weston_window_switcher_implementation, self, _weston_window_switcher_unbind);
+
+    wl_list_insert(&switcher->clients, &self->link);
+
+    if ( version >= ZWW_WINDOW_SWITCHER_V1_SET_PAGED_SINCE_VERSION )
+        self->announce_idle = wl_event_loop_add_idle(wl_display_get_event_loop(switcher->compositor->wl_display), _weston_window_switcher_client_announce, self);
+    if ( self->announce_idle == NULL )
+        _weston_window_switcher_client_announce(self);
+}
+
+static void
+_weston_window_switcher_stats(void *data, struct ww_stats_sink *sink)
+{
+    struct weston_window_switcher *self = data;
+
+    ww_stats_counter(sink, "windows", self->window_count);
+    ww_stats_counter(sink, "clients", wl_list_length(&self->clients));
+    ww_stats_counter(sink, "previews", wl_list_length(&self->previews));
+    ww_stats_counter(sink, "cycles-started", self->stats.cycles_started);
+    ww_stats_counter(sink, "cycles-committed", self->stats.cycles_committed);
+    ww_stats_counter(sink, "cycles-cancelled", self->stats.cycles_cancelled);
+    ww_stats_histogram(sink, "update", &self->stats.update);
+    ww_stats_histogram(sink, "search", &self->stats.search);
 }
 
+#ifdef WW_COMBINED_MODULE
+int
+weston_window_switcher_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#else /* ! WW_COMBINED_MODULE */
 WW_EXPORT int
 wet_module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+#endif /* ! WW_COMBINED_MODULE */
 {
     struct weston_window_switcher *self;
 
+    ww_trace_init(compositor);
+
     self = zalloc(sizeof(struct weston_window_switcher));
     if ( self == NULL )
         return -1;
 
     self->compositor = compositor;
 
+    struct weston_config_section *section = weston_config_get_section(wet_get_config(self->compositor), "window-switcher", NULL, NULL);
+    weston_config_section_get_uint(section, "thumbnail-interval", &self->thumbnail_interval, 100);
+    weston_config_section_get_uint(section, "title-interval", &self->title_interval, 0);
+
+    int cycle;
+    char *cycle_modifier;
+    weston_config_section_get_bool(section, "cycle", &cycle, false);
+    weston_config_section_get_string(section, "cycle-modifier", &cycle_modifier, "alt");
+    if ( strcmp(cycle_modifier, "super") == 0 )
+        self->cycle_modifier = MODIFIER_SUPER;
+    else if ( strcmp(cycle_modifier, "ctrl") == 0 )
+        self->cycle_modifier = MODIFIER_CTRL;
+    else
+        self->cycle_modifier = MODIFIER_ALT;
+    free(cycle_modifier);
+
+    wl_list_init(&self->clients);
+    wl_list_init(&self->pending);
     wl_list_init(&self->windows);
+    wl_list_init(&self->dirty);
+    wl_list_init(&self->outputs);
+    wl_list_init(&self->seats);
+    wl_list_init(&self->previews);
+
+    weston_layer_init(&self->layer, self->compositor);
+    weston_layer_set_position(&self->layer, WESTON_LAYER_POSITION_NORMAL + 1);
 
-    if ( wl_global_create(self->compositor->wl_display, &zww_window_switcher_v1_interface, 1, self, _weston_window_switcher_bind) == NULL)
+    if ( wl_global_create(self->compositor->wl_display, &zww_window_switcher_v1_interface, WESTON_WINDOW_SWITCHER_VERSION, self, _weston_window_switcher_bind) == NULL)
         return -1;
 
+    self->title_timer = wl_event_loop_add_timer(wl_display_get_event_loop(self->compositor->wl_display), _weston_window_switcher_title_timeout, self);
+    if ( self->title_timer == NULL )
+        return -1;
+
+    self->create_surface_listener.notify = _weston_window_switcher_surface_created;
+    self->output_created_listener.notify = _weston_window_switcher_output_created;
+    self->output_destroyed_listener.notify = _weston_window_switcher_output_destroyed;
+    self->seat_created_listener.notify = _weston_window_switcher_seat_created;
+    wl_signal_add(&self->compositor->create_surface_signal, &self->create_surface_listener);
+    wl_signal_add(&self->compositor->output_created_signal, &self->output_created_listener);
+    wl_signal_add(&self->compositor->output_destroyed_signal, &self->output_destroyed_listener);
+    wl_signal_add(&self->compositor->seat_created_signal, &self->seat_created_listener);
+
+    if ( cycle )
+        weston_compositor_add_key_binding(self->compositor, KEY_TAB, self->cycle_modifier, _weston_window_switcher_cycle_binding, self);
+
+    struct weston_output *output;
+    wl_list_for_each(output, &self->compositor->output_list, link)
+        _weston_window_switcher_output_add(self, output);
+
+    struct weston_seat *seat;
+    wl_list_for_each(seat, &self->compositor->seat_list, link)
+        _weston_window_switcher_seat_add(self, seat);
+
+    /* Pick up windows mapped before we were loaded */
+    struct weston_view *view;
+    wl_list_for_each(view, &self->compositor->view_list, link)
+    {
+        struct weston_window_switcher_window *window = _weston_window_switcher_track_surface(self, view->surface);
+        if ( window != NULL )
+            _weston_window_switcher_window_mark(window, WESTON_WINDOW_SWITCHER_WINDOW_DIRTY_CONTENT);
+    }
+    if ( ! wl_list_empty(&self->dirty) )
+        weston_compositor_schedule_repaint(self->compositor);
+
+    ww_stats_init(compositor, "window-switcher", _weston_window_switcher_stats, self);
+
     return 0;
 }
@@ -0,0 +1,473 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include <wayland-client.h>
+#include "unstable/notification-area/notification-area-unstable-v1-client-protocol.h"
+#include "unstable/dock-manager/dock-manager-unstable-v2-client-protocol.h"
+#include "unstable/window-switcher/window-switcher-unstable-v1-client-protocol.h"
+
+/*
+ * Measures the latency of a few requests against a running compositor,
+ * see latency-test.sh, and compares each median to a stored baseline:
+ * - notification-map, dock-map, window-map: role request, attach and
+ *   commit up to the first frame callback
+ * - switcher-bind: window-switcher bind to the end of the initial announce
+ * The test fails if a median is over its baseline times the tolerance
+ * With --record, the medians are written out as the new baselines
+ */
+
+#define WW_LATENCY_TEST_BUFFER_SIZE 64
+#define WW_LATENCY_TEST_TIMEOUT 120
+
+enum ww_latency_test_case {
+    WW_LATENCY_TEST_CASE_NOTIFICATION_MAP,
+    WW_LATENCY_TEST_CASE_DOCK_MAP,
+    WW_LATENCY_TEST_CASE_WINDOW_MAP,
+    WW_LATENCY_TEST_CASE_SWITCHER_BIND,
+    _WW_LATENCY_TEST_CASE_SIZE
+};
+
+static const char * const _ww_latency_test_cases[_WW_LATENCY_TEST_CASE_SIZE] = {
+    [WW_LATENCY_TEST_CASE_NOTIFICATION_MAP] = "notification-map",
+    [WW_LATENCY_TEST_CASE_DOCK_MAP] = "dock-map",
+    [WW_LATENCY_TEST_CASE_WINDOW_MAP] = "window-map",
+    [WW_LATENCY_TEST_CASE_SWITCHER_BIND] = "switcher-bind",
+};
+
+struct ww_latency_test {
+    size_t iterations;
+    double tolerance;
+    struct wl_display *display;
+    struct wl_registry *registry;
+    struct wl_compositor *compositor;
+    struct wl_shm *shm;
+    struct wl_shell *shell;
+    struct wl_output *output;
+    struct zww_notification_area_v1 *notification_area;
+    struct zww_dock_manager_v2 *dock_manager;
+    uint32_t window_switcher_name;
+    struct wl_buffer *buffer;
+    struct wl_buffer *dock_buffer;
+    bool done;
+    uint64_t baselines[_WW_LATENCY_TEST_CASE_SIZE];
+};
+
+static uint64_t
+_ww_latency_test_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static struct wl_buffer *
+_ww_latency_test_create_buffer(struct ww_latency_test *self, int32_t width, int32_t height)
+{
+    int32_t stride = width * 4;
+    int32_t size = stride * height;
+    const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+    struct wl_shm_pool *pool;
+    struct wl_buffer *buffer;
+    char path[256];
+    void *data;
+    int fd;
+
+    if ( runtime_dir == NULL )
+        return NULL;
+
+    snprintf(path, sizeof(path), "%s/ww-latency-test-XXXXXX", runtime_dir);
+    fd = mkstemp(path);
+    if ( fd < 0 )
+        return NULL;
+    unlink(path);
+
+    if ( ftruncate(fd, size) < 0 )
+    {
+        close(fd);
+        return NULL;
+    }
+
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if ( data == MAP_FAILED )
+    {
+        close(fd);
+        return NULL;
+    }
+    memset(data, 0x80, size);
+    munmap(data, size);
+
+    pool = wl_shm_create_pool(self->shm, fd, size);
+    buffer = wl_shm_pool_create_buffer(pool, 0, width, height, stride, WL_SHM_FORMAT_XRGB8888);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+
+    return buffer;
+}
+
+static int
+_ww_latency_test_parse_baselines(struct ww_latency_test *self, const char *path)
+{
+    char line[256], name[64];
+    unsigned long long value;
+    enum ww_latency_test_case tcase;
+    FILE *f;
+
+    f = fopen(path, "r");
+    if ( f == NULL )
+    {
+        fprintf(stderr, "Could not open the baselines %s\n", path);
+        return -1;
+    }
+
+    while ( fgets(line, sizeof(line), f) != NULL )
+    {
+        if ( ( line[0] == '#' ) || ( sscanf(line, "%63s %llu", name, &value) != 2 ) )
+            continue;
+        for ( tcase = 0 ; tcase < _WW_LATENCY_TEST_CASE_SIZE ; ++tcase )
+        {
+            if ( strcmp(name, _ww_latency_test_cases[tcase]) == 0 )
+                self->baselines[tcase] = value;
+        }
+    }
+    fclose(f);
+
+    for ( tcase = 0 ; tcase < _WW_LATENCY_TEST_CASE_SIZE ; ++tcase )
+    {
+        if ( self->baselines[tcase] == 0 )
+        {
+            fprintf(stderr, "No baseline for %s in %s\n", _ww_latency_test_cases[tcase], path);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void
+_ww_latency_test_shell_surface_ping(void *data, struct wl_shell_surface *shell_surface, uint32_t serial)
+{
+    wl_shell_surface_pong(shell_surface, serial);
+}
+
+static void
+_ww_latency_test_shell_surface_configure(void *data, struct wl_shell_surface *shell_surface, uint32_t edges, int32_t width, int32_t height)
+{
+}
+
+static void
+_ww_latency_test_shell_surface_popup_done(void *data, struct wl_shell_surface *shell_surface)
+{
+}
+
+static const struct wl_shell_surface_listener _ww_latency_test_shell_surface_listener = {
+    .ping = _ww_latency_test_shell_surface_ping,
+    .configure = _ww_latency_test_shell_surface_configure,
+    .popup_done = _ww_latency_test_shell_surface_popup_done,
+};
+
+static void
+_ww_latency_test_done(void *data, struct wl_callback *callback, uint32_t time)
+{
+    struct ww_latency_test *self = data;
+
+    self->done = true;
+    wl_callback_destroy(callback);
+}
+
+static const struct wl_callback_listener _ww_latency_test_done_listener = {
+    .done = _ww_latency_test_done,
+};
+
+static void
+_ww_latency_test_switcher_window(void *data, struct zww_window_switcher_v1 *switcher, struct zww_window_switcher_window_v1 *window)
+{
+    zww_window_switcher_window_v1_destroy(window);
+}
+
+static const struct zww_window_switcher_v1_listener _ww_latency_test_switcher_listener = {
+    .window = _ww_latency_test_switcher_window,
+};
+
+static int
+_ww_latency_test_wait(struct ww_latency_test *self)
+{
+    while ( ! self->done )
+    {
+        if ( wl_display_dispatch(self->display) < 0 )
+            return -1;
+    }
+    return 0;
+}
+
+/* A role request, attach and commit, up to the first frame */
+static int
+_ww_latency_test_map(struct ww_latency_test *self, enum ww_latency_test_case tcase, uint64_t *time)
+{
+    struct wl_surface *surface;
+    struct wl_shell_surface *shell_surface = NULL;
+    struct zww_notification_v1 *notification = NULL;
+    struct zww_dock_v2 *dock = NULL;
+    struct wl_buffer *buffer = self->buffer;
+    struct wl_callback *callback;
+    uint64_t start;
+
+    start = _ww_latency_test_now();
+    surface = wl_compositor_create_surface(self->compositor);
+    switch ( tcase )
+    {
+    case WW_LATENCY_TEST_CASE_NOTIFICATION_MAP:
+        notification = zww_notification_area_v1_create_notification(self->notification_area, surface);
+        /* Notifications are mapped by their first move */
+        zww_notification_v1_move(notification, 0, 0);
+    break;
+    case WW_LATENCY_TEST_CASE_DOCK_MAP:
+        dock = zww_dock_manager_v2_create_dock(self->dock_manager, surface, self->output, ZWW_DOCK_MANAGER_V2_POSITION_TOP);
+        buffer = self->dock_buffer;
+    break;
+    case WW_LATENCY_TEST_CASE_WINDOW_MAP:
+        shell_surface = wl_shell_get_shell_surface(self->shell, surface);
+        wl_shell_surface_add_listener(shell_surface, &_ww_latency_test_shell_surface_listener, self);
+        wl_shell_surface_set_toplevel(shell_surface);
+    break;
+    case WW_LATENCY_TEST_CASE_SWITCHER_BIND:
+    case _WW_LATENCY_TEST_CASE_SIZE:
+    break;
+    }
+
+    self->done = false;
+    callback = wl_surface_frame(surface);
+    wl_callback_add_listener(callback, &_ww_latency_test_done_listener, self);
+    wl_surface_attach(surface, buffer, 0, 0);
+    wl_surface_damage(surface, 0, 0, WW_LATENCY_TEST_BUFFER_SIZE, WW_LATENCY_TEST_BUFFER_SIZE);
+    wl_surface_commit(surface);
+    if ( _ww_latency_test_wait(self) < 0 )
+        return -1;
+    *time = _ww_latency_test_now() - start;
+
+    /* Unmap, so every iteration starts from the same state */
+    if ( notification != NULL )
+        zww_notification_v1_destroy(notification);
+    if ( dock != NULL )
+        zww_dock_v2_destroy(dock);
+    if ( shell_surface != NULL )
+        wl_shell_surface_destroy(shell_surface);
+    wl_surface_destroy(surface);
+
+    return ( wl_display_roundtrip(self->display) < 0 ) ? -1 : 0;
+}
+
+/* A version 1 bind is announced right away, a sync is enough to wait for it */
+static int
+_ww_latency_test_bind(struct ww_latency_test *self, uint64_t *time)
+{
+    struct zww_window_switcher_v1 *switcher;
+    struct wl_callback *callback;
+    uint64_t start;
+
+    start = _ww_latency_test_now();
+    switcher = wl_registry_bind(self->registry, self->window_switcher_name, &zww_window_switcher_v1_interface, 1);
+    zww_window_switcher_v1_add_listener(switcher, &_ww_latency_test_switcher_listener, self);
+
+    self->done = false;
+    callback = wl_display_sync(self->display);
+    wl_callback_add_listener(callback, &_ww_latency_test_done_listener, self);
+    if ( _ww_latency_test_wait(self) < 0 )
+        return -1;
+    *time = _ww_latency_test_now() - start;
+
+    zww_window_switcher_v1_destroy(switcher);
+    return 0;
+}
+
+static int
+_ww_latency_test_compare(const void *a_, const void *b_)
+{
+    const uint64_t *a = a_, *b = b_;
+
+    return ( *a > *b ) - ( *a < *b );
+}
+
+static int
+_ww_latency_test_run(struct ww_latency_test *self, enum ww_latency_test_case tcase, uint64_t *median)
+{
+    uint64_t *times;
+    size_t i;
+    int r = 0;
+
+    times = calloc(self->iterations, sizeof(uint64_t));
+    if ( times == NULL )
+        return -1;
+
+    for ( i = 0 ; ( r == 0 ) && ( i < self->iterations ) ; ++i )
+    {
+        if ( tcase == WW_LATENCY_TEST_CASE_SWITCHER_BIND )
+            r = _ww_latency_test_bind(self, &times[i]);
+        else
+            r = _ww_latency_test_map(self, tcase, &times[i]);
+    }
+
+    if ( r == 0 )
+    {
+        qsort(times, self->iterations, sizeof(uint64_t), _ww_latency_test_compare);
+        *median = times[self->iterations / 2] / 1000;
+    }
+    free(times);
+
+    return ( r < 0 ) ? -1 : 0;
+}
+
+static void
+_ww_latency_test_registry_global(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    struct ww_latency_test *self = data;
+
+    if ( strcmp(interface, wl_compositor_interface.name) == 0 )
+        self->compositor = wl_registry_bind(registry, name, &wl_compositor_interface, 1);
+    else if ( strcmp(interface, wl_shm_interface.name) == 0 )
+        self->shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+    else if ( strcmp(interface, wl_shell_interface.name) == 0 )
+        self->shell = wl_registry_bind(registry, name, &wl_shell_interface, 1);
+    else if ( ( strcmp(interface, wl_output_interface.name) == 0 ) && ( self->output == NULL ) )
+        self->output = wl_registry_bind(registry, name, &wl_output_interface, 1);
+    else if ( strcmp(interface, zww_notification_area_v1_interface.name) == 0 )
+        self->notification_area = wl_registry_bind(registry, name, &zww_notification_area_v1_interface, 1);
+    else if ( strcmp(interface, zww_dock_manager_v2_interface.name) == 0 )
+        self->dock_manager = wl_registry_bind(registry, name, &zww_dock_manager_v2_interface, 1);
+    else if ( strcmp(interface, zww_window_switcher_v1_interface.name) == 0 )
+        self->window_switcher_name = name;
+}
+
+static void
+_ww_latency_test_registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+}
+
+static const struct wl_registry_listener _ww_latency_test_registry_listener = {
+    .global = _ww_latency_test_registry_global,
+    .global_remove = _ww_latency_test_registry_global_remove,
+};
+
+int
+main(int argc, char *argv[])
+{
+    struct ww_latency_test self_ = { .iterations = 21, .tolerance = 3. }, *self = &self_;
+    enum ww_latency_test_case tcase;
+    uint64_t median;
+    const char *tolerance;
+    bool record = false;
+    int ret = 0;
+
+    if ( ( argc > 1 ) && ( strcmp(argv[1], "--record") == 0 ) )
+    {
+        record = true;
+        --argc;
+        ++argv;
+    }
+    if ( ( argc < 2 ) || ( argc > 3 ) )
+    {
+        fprintf(stderr, "Usage: latency-test [--record] <baselines> [iterations]\n");
+        return 2;
+    }
+    if ( argc > 2 )
+        self->iterations = strtoul(argv[2], NULL, 10);
+    if ( self->iterations == 0 )
+        self->iterations = 1;
+    tolerance = getenv("WW_LATENCY_TOLERANCE");
+    if ( tolerance != NULL )
+        self->tolerance = strtod(tolerance, NULL);
+
+    if ( ( ! record ) && ( _ww_latency_test_parse_baselines(self, argv[1]) < 0 ) )
+        return 1;
+
+    /* A stuck compositor must not stall make check */
+    alarm(WW_LATENCY_TEST_TIMEOUT);
+
+    self->display = wl_display_connect(NULL);
+    if ( self->display == NULL )
+    {
+        fprintf(stderr, "Could not connect to the compositor\n");
+        return 1;
+    }
+
+    self->registry = wl_display_get_registry(self->display);
+    wl_registry_add_listener(self->registry, &_ww_latency_test_registry_listener, self);
+    wl_display_roundtrip(self->display);
+
+    if ( ( self->compositor == NULL ) || ( self->shm == NULL ) || ( self->shell == NULL ) || ( self->output == NULL ) || ( self->notification_area == NULL ) || ( self->dock_manager == NULL ) || ( self->window_switcher_name == 0 ) )
+    {
+        fprintf(stderr, "Missing globals, are all the modules loaded?\n");
+        return 1;
+    }
+
+    self->buffer = _ww_latency_test_create_buffer(self, WW_LATENCY_TEST_BUFFER_SIZE, WW_LATENCY_TEST_BUFFER_SIZE);
+    self->dock_buffer = _ww_latency_test_create_buffer(self, WW_LATENCY_TEST_BUFFER_SIZE, 1);
+    if ( ( self->buffer == NULL ) || ( self->dock_buffer == NULL ) )
+    {
+        fprintf(stderr, "Could not create the buffer\n");
+        return 1;
+    }
+
+    if ( record )
+    {
+        printf("# Median latency in microseconds, per case, on the reference machine\n");
+        printf("# Written by make latency-baselines, checked by make check\n");
+    }
+
+    for ( tcase = 0 ; tcase < _WW_LATENCY_TEST_CASE_SIZE ; ++tcase )
+    {
+        if ( _ww_latency_test_run(self, tcase, &median) < 0 )
+        {
+            fprintf(stderr, "Lost the compositor in %s\n", _ww_latency_test_cases[tcase]);
+            return 1;
+        }
+
+        if ( record )
+            printf("%s %llu\n", _ww_latency_test_cases[tcase], (unsigned long long) median);
+        else if ( median > self->baselines[tcase] * self->tolerance )
+        {
+            fprintf(stderr, "%s: regression, median %llu µs, baseline %llu µs, tolerance %.2f\n", _ww_latency_test_cases[tcase], (unsigned long long) median, (unsigned long long) self->baselines[tcase], self->tolerance);
+            ret = 1;
+        }
+        else
+            fprintf(stderr, "%s: median %llu µs, baseline %llu µs\n", _ww_latency_test_cases[tcase], (unsigned long long) median, (unsigned long long) self->baselines[tcase]);
+    }
+
+    wl_display_disconnect(self->display);
+
+    return ret;
+}
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Runs the latency test against a headless Weston loading the
+# notification-area, dock-manager and window-switcher plugins
+#
+# Usage: latency-test.sh [--record] [iterations]
+# make check sets WW_LATENCY_TEST, WW_MODULE_DIR and WW_LATENCY_BASELINES
+# With --record, the new baselines are written on the standard output
+# Set WESTON to use another weston binary, WW_LATENCY_TOLERANCE to change
+# the allowed factor over the baselines
+# The test is skipped if there is no weston binary
+#
+
+set -e
+
+if [ -z "${WW_LATENCY_TEST}" ] || [ -z "${WW_MODULE_DIR}" ] || [ -z "${WW_LATENCY_BASELINES}" ]; then
+    echo "WW_LATENCY_TEST, WW_MODULE_DIR and WW_LATENCY_BASELINES must be set" >&2
+    exit 2
+fi
+
+weston="${WESTON:-weston}"
+if ! command -v "${weston}" >/dev/null 2>&1; then
+    echo "No ${weston} binary, skipping" >&2
+    exit 77
+fi
+
+record=
+if [ "$1" = "--record" ]; then
+    record="$1"
+    shift
+fi
+
+runtime_dir=$(mktemp -d)
+chmod 700 "${runtime_dir}"
+export XDG_RUNTIME_DIR="${runtime_dir}"
+socket=ww-latency-test
+
+modules=
+for module in notification-area dock-manager window-switcher; do
+    modules="${modules}${modules:+,}${WW_MODULE_DIR}/${module}.so"
+done
+
+"${weston}" --backend=headless-backend.so --socket="${socket}" --no-config --modules="${modules}" >"${runtime_dir}/weston.log" 2>&1 &
+pid=$!
+trap 'kill ${pid} 2>/dev/null; wait ${pid} 2>/dev/null; rm -rf "${runtime_dir}"' EXIT
+
+tries=0
+while [ ! -S "${runtime_dir}/${socket}" ]; do
+    tries=$((tries + 1))
+    if [ ${tries} -gt 100 ] || ! kill -0 ${pid} 2>/dev/null; then
+        echo "Weston did not start" >&2
+        cat "${runtime_dir}/weston.log" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+WAYLAND_DISPLAY="${socket}" "${WW_LATENCY_TEST}" ${record} "${WW_LATENCY_BASELINES}" "$@"
@@ -0,0 +1,201 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "layout.h"
+
+/*
+ * Runs the layout functions on random inputs, built against the stub
+ * compositor.h so it needs no libweston, and prints nanoseconds per call
+ * Inputs are drawn beforehand so the loops only time the calls
+ */
+
+#define WW_LAYOUT_BENCHMARK_INPUTS 4096
+
+struct ww_layout_benchmark_axis {
+    int32_t start;
+    int32_t length;
+    uint32_t flags;
+    int32_t size;
+    int32_t bounds_start;
+    int32_t bounds_length;
+};
+
+struct ww_layout_benchmark_dock {
+    struct weston_geometry output;
+    struct ww_layout_extents extents;
+    enum ww_layout_edge edge;
+    int32_t width;
+    int32_t height;
+    int32_t offset;
+};
+
+static struct ww_layout_benchmark_axis _ww_layout_benchmark_axes[WW_LAYOUT_BENCHMARK_INPUTS];
+static struct ww_layout_benchmark_dock _ww_layout_benchmark_docks[WW_LAYOUT_BENCHMARK_INPUTS];
+
+/* Keeps the results alive */
+static volatile int64_t _ww_layout_benchmark_sink;
+
+static uint64_t
+_ww_layout_benchmark_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int32_t
+_ww_layout_benchmark_random(int32_t min, int32_t max)
+{
+    return min + rand() % ( max - min + 1 );
+}
+
+static void
+_ww_layout_benchmark_fill(void)
+{
+    size_t i;
+
+    srand(1);
+    for ( i = 0 ; i < WW_LAYOUT_BENCHMARK_INPUTS ; ++i )
+    {
+        struct ww_layout_benchmark_axis *axis = &_ww_layout_benchmark_axes[i];
+        struct ww_layout_benchmark_dock *dock = &_ww_layout_benchmark_docks[i];
+
+        axis->bounds_start = _ww_layout_benchmark_random(-2000, 2000);
+        axis->bounds_length = _ww_layout_benchmark_random(0, 4000);
+        axis->start = _ww_layout_benchmark_random(axis->bounds_start - 100, axis->bounds_start + axis->bounds_length + 100);
+        axis->length = _ww_layout_benchmark_random(0, 200);
+        axis->size = _ww_layout_benchmark_random(1, 1000);
+        axis->flags = rand() % 64;
+
+        dock->output.x = _ww_layout_benchmark_random(-4000, 4000);
+        dock->output.y = _ww_layout_benchmark_random(-4000, 4000);
+        dock->output.width = _ww_layout_benchmark_random(640, 4000);
+        dock->output.height = _ww_layout_benchmark_random(480, 4000);
+        dock->extents.top = _ww_layout_benchmark_random(0, 100);
+        dock->extents.bottom = _ww_layout_benchmark_random(0, 100);
+        dock->extents.left = _ww_layout_benchmark_random(0, 100);
+        dock->extents.right = _ww_layout_benchmark_random(0, 100);
+        dock->edge = rand() % 4;
+        dock->width = _ww_layout_benchmark_random(1, 200);
+        dock->height = _ww_layout_benchmark_random(1, 200);
+        dock->offset = _ww_layout_benchmark_random(0, 200);
+    }
+}
+
+#define WW_LAYOUT_BENCHMARK_FLAG(flags, n) ( ( (flags) & ( 1 << (n) ) ) != 0 )
+
+static void
+_ww_layout_benchmark_report(const char *name, uint64_t start, size_t iterations)
+{
+    printf("%-24s %8.2f ns/call\n", name, (double) ( _ww_layout_benchmark_now() - start ) / iterations);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t iterations = 10000000, i;
+    int64_t sink = 0;
+    uint64_t start;
+
+    if ( argc > 1 )
+        iterations = strtoul(argv[1], NULL, 10);
+    if ( iterations == 0 )
+        iterations = 1;
+
+    _ww_layout_benchmark_fill();
+
+    start = _ww_layout_benchmark_now();
+    for ( i = 0 ; i < iterations ; ++i )
+    {
+        const struct ww_layout_benchmark_axis *axis = &_ww_layout_benchmark_axes[i % WW_LAYOUT_BENCHMARK_INPUTS];
+        uint32_t flags = axis->flags;
+
+        sink += ww_layout_positioner_solve_axis(axis->start, axis->length,
+            WW_LAYOUT_BENCHMARK_FLAG(flags, 0), WW_LAYOUT_BENCHMARK_FLAG(flags, 1),
+            WW_LAYOUT_BENCHMARK_FLAG(flags, 2), WW_LAYOUT_BENCHMARK_FLAG(flags, 3),
+            WW_LAYOUT_BENCHMARK_FLAG(flags, 4), WW_LAYOUT_BENCHMARK_FLAG(flags, 5),
+            axis->size, axis->bounds_start, axis->bounds_length);
+    }
+    _ww_layout_benchmark_report("positioner_solve_axis", start, iterations);
+
+    start = _ww_layout_benchmark_now();
+    for ( i = 0 ; i < iterations ; ++i )
+    {
+        const struct ww_layout_benchmark_axis *axis = &_ww_layout_benchmark_axes[i % WW_LAYOUT_BENCHMARK_INPUTS];
+        uint32_t flags = axis->flags;
+
+        sink += ww_layout_positioner_available_axis(axis->start, axis->length,
+            WW_LAYOUT_BENCHMARK_FLAG(flags, 0), WW_LAYOUT_BENCHMARK_FLAG(flags, 1),
+            WW_LAYOUT_BENCHMARK_FLAG(flags, 2), WW_LAYOUT_BENCHMARK_FLAG(flags, 3),
+            WW_LAYOUT_BENCHMARK_FLAG(flags, 4), WW_LAYOUT_BENCHMARK_FLAG(flags, 5),
+            axis->bounds_start, axis->bounds_length);
+    }
+    _ww_layout_benchmark_report("positioner_available_axis", start, iterations);
+
+    start = _ww_layout_benchmark_now();
+    for ( i = 0 ; i < iterations ; ++i )
+    {
+        const struct ww_layout_benchmark_dock *dock = &_ww_layout_benchmark_docks[i % WW_LAYOUT_BENCHMARK_INPUTS];
+        struct weston_geometry area = ww_layout_workarea(&dock->output, &dock->extents);
+
+        sink += area.x + area.y + area.width + area.height;
+    }
+    _ww_layout_benchmark_report("workarea", start, iterations);
+
+    start = _ww_layout_benchmark_now();
+    for ( i = 0 ; i < iterations ; ++i )
+    {
+        const struct ww_layout_benchmark_dock *dock = &_ww_layout_benchmark_docks[i % WW_LAYOUT_BENCHMARK_INPUTS];
+        int32_t x, y;
+
+        ww_layout_dock_position(&dock->output, dock->edge, dock->width, dock->height, dock->offset, &x, &y);
+        sink += x + y;
+    }
+    _ww_layout_benchmark_report("dock_position", start, iterations);
+
+    start = _ww_layout_benchmark_now();
+    for ( i = 0 ; i < iterations ; ++i )
+    {
+        const struct ww_layout_benchmark_dock *dock = &_ww_layout_benchmark_docks[i % WW_LAYOUT_BENCHMARK_INPUTS];
+        int32_t x, y;
+
+        /* The dock size stands for the position in the work area */
+        ww_layout_notification_position(&dock->output, dock->width, dock->height, &x, &y);
+        sink += x + y;
+    }
+    _ww_layout_benchmark_report("notification_position", start, iterations);
+
+    _ww_layout_benchmark_sink = sink;
+
+    return 0;
+}
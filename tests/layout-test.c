@@ -0,0 +1,152 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "layout.h"
+#include "ww-test.h"
+
+static void
+_ww_layout_test_solve_axis(void)
+{
+    /* Below the anchor rectangle */
+    ww_test_check_int(ww_layout_positioner_solve_axis(100, 20, false, true, false, true, false, false, 50, 0, 1000), 120);
+    /* Above it */
+    ww_test_check_int(ww_layout_positioner_solve_axis(100, 20, true, false, true, false, false, false, 50, 0, 1000), 50);
+    /* Centred on it */
+    ww_test_check_int(ww_layout_positioner_solve_axis(100, 20, false, false, false, false, false, false, 50, 0, 1000), 85);
+
+    /* Flipped above as it does not fit below */
+    ww_test_check_int(ww_layout_positioner_solve_axis(950, 20, false, true, false, true, true, false, 100, 0, 1000), 850);
+    /* Not flipped when the other side does not fit either */
+    ww_test_check_int(ww_layout_positioner_solve_axis(950, 20, false, true, false, true, true, false, 2000, 0, 1000), 970);
+    /* Slid back in */
+    ww_test_check_int(ww_layout_positioner_solve_axis(990, 0, true, false, false, true, false, true, 50, 0, 1000), 950);
+    /* Bigger than the bounds, slid to their start */
+    ww_test_check_int(ww_layout_positioner_solve_axis(950, 20, false, true, false, true, true, true, 2000, 0, 1000), 0);
+    /* Bounds not starting at 0 */
+    ww_test_check_int(ww_layout_positioner_solve_axis(0, 10, false, true, false, true, false, true, 50, 100, 200), 100);
+}
+
+static void
+_ww_layout_test_available_axis(void)
+{
+    ww_test_check_int(ww_layout_positioner_available_axis(100, 20, false, true, false, true, false, true, 0, 1000), 1000);
+    ww_test_check_int(ww_layout_positioner_available_axis(100, 20, false, true, false, true, false, false, 0, 1000), 880);
+    ww_test_check_int(ww_layout_positioner_available_axis(100, 20, false, true, true, false, false, false, 0, 1000), 120);
+    ww_test_check_int(ww_layout_positioner_available_axis(100, 20, false, true, true, false, true, false, 0, 1000), 880);
+    ww_test_check_int(ww_layout_positioner_available_axis(100, 20, false, false, false, false, false, false, 0, 1000), 220);
+    /* Anchored out of the bounds */
+    ww_test_check_int(ww_layout_positioner_available_axis(-50, 0, true, false, true, false, false, false, 0, 1000), 0);
+}
+
+static void
+_ww_layout_test_workarea(void)
+{
+    struct weston_geometry output = { .x = 10, .y = 20, .width = 1000, .height = 800 };
+    struct ww_layout_extents extents = { .top = 30, .bottom = 40, .left = 5, .right = 6 };
+    struct ww_layout_extents none = { 0 };
+    struct weston_geometry area;
+
+    area = ww_layout_workarea(&output, &extents);
+    ww_test_check_int(area.x, 15);
+    ww_test_check_int(area.y, 50);
+    ww_test_check_int(area.width, 989);
+    ww_test_check_int(area.height, 730);
+
+    area = ww_layout_workarea(&output, &none);
+    ww_test_check_int(area.x, output.x);
+    ww_test_check_int(area.y, output.y);
+    ww_test_check_int(area.width, output.width);
+    ww_test_check_int(area.height, output.height);
+}
+
+static void
+_ww_layout_test_dock_position(void)
+{
+    struct weston_geometry output = { .x = 10, .y = 20, .width = 1000, .height = 800 };
+    int32_t x, y;
+
+    ww_layout_dock_position(&output, WW_LAYOUT_EDGE_TOP, 1000, 30, 0, &x, &y);
+    ww_test_check_int(x, 10);
+    ww_test_check_int(y, 20);
+
+    ww_layout_dock_position(&output, WW_LAYOUT_EDGE_TOP, 1000, 30, 30, &x, &y);
+    ww_test_check_int(x, 10);
+    ww_test_check_int(y, 50);
+
+    ww_layout_dock_position(&output, WW_LAYOUT_EDGE_BOTTOM, 1000, 30, 10, &x, &y);
+    ww_test_check_int(x, 10);
+    ww_test_check_int(y, 780);
+
+    ww_layout_dock_position(&output, WW_LAYOUT_EDGE_LEFT, 40, 800, 5, &x, &y);
+    ww_test_check_int(x, 15);
+    ww_test_check_int(y, 20);
+
+    ww_layout_dock_position(&output, WW_LAYOUT_EDGE_RIGHT, 40, 800, 5, &x, &y);
+    ww_test_check_int(x, 965);
+    ww_test_check_int(y, 20);
+}
+
+static void
+_ww_layout_test_notification_position(void)
+{
+    struct weston_geometry workarea = { .x = 40, .y = 30, .width = 960, .height = 770 };
+    int32_t x, y;
+
+    ww_layout_notification_position(&workarea, 0, 0, &x, &y);
+    ww_test_check_int(x, 40);
+    ww_test_check_int(y, 30);
+
+    ww_layout_notification_position(&workarea, 700, 500, &x, &y);
+    ww_test_check_int(x, 740);
+    ww_test_check_int(y, 530);
+
+    /* Clients may place notifications partly off the work area */
+    ww_layout_notification_position(&workarea, -50, -40, &x, &y);
+    ww_test_check_int(x, -10);
+    ww_test_check_int(y, -10);
+
+    /* The result may alias the input, as the notification area does */
+    x = 10;
+    y = 20;
+    ww_layout_notification_position(&workarea, x, y, &x, &y);
+    ww_test_check_int(x, 50);
+    ww_test_check_int(y, 50);
+}
+
+int
+main(void)
+{
+    _ww_layout_test_solve_axis();
+    _ww_layout_test_available_axis();
+    _ww_layout_test_workarea();
+    _ww_layout_test_dock_position();
+    _ww_layout_test_notification_position();
+
+    return ww_test_result();
+}
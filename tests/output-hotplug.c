@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <signal.h>
+
+#include <wayland-server.h>
+#include <compositor.h>
+
+/*
+ * Benchmark helper module, not installed: the headless backend cannot
+ * add outputs at runtime, so hotplug is played by disabling an output
+ * on SIGUSR1 and enabling it again on SIGUSR2
+ * The plugins see the same output destroyed and created signals, and
+ * clients the same global removal and announce, as for a real hotplug
+ */
+
+struct ww_output_hotplug {
+    struct weston_compositor *compositor;
+    struct weston_output *output;
+};
+
+static int
+_ww_output_hotplug_unplug(int signal_number, void *data)
+{
+    struct ww_output_hotplug *self = data;
+
+    /* One output at a time, the next signal plugs it back */
+    if ( ( self->output != NULL ) || wl_list_empty(&self->compositor->output_list) )
+        return 0;
+
+    self->output = wl_container_of(self->compositor->output_list.prev, self->output, link);
+    weston_output_disable(self->output);
+
+    return 0;
+}
+
+static int
+_ww_output_hotplug_plug(int signal_number, void *data)
+{
+    struct ww_output_hotplug *self = data;
+    struct weston_output *output = self->output;
+
+    if ( output == NULL )
+        return 0;
+
+    self->output = NULL;
+    if ( weston_output_enable(output) < 0 )
+        weston_log("output-hotplug: could not enable %s again\n", output->name);
+
+    return 0;
+}
+
+WW_EXPORT int
+wet_module_init(struct weston_compositor *compositor, int *argc, char *argv[])
+{
+    struct wl_event_loop *loop = wl_display_get_event_loop(compositor->wl_display);
+    struct ww_output_hotplug *self;
+
+    self = zalloc(sizeof(struct ww_output_hotplug));
+    if ( self == NULL )
+        return -1;
+
+    self->compositor = compositor;
+
+    if ( wl_event_loop_add_signal(loop, SIGUSR1, _ww_output_hotplug_unplug, self) == NULL )
+        return -1;
+    if ( wl_event_loop_add_signal(loop, SIGUSR2, _ww_output_hotplug_plug, self) == NULL )
+        return -1;
+
+    return 0;
+}
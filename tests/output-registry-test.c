@@ -0,0 +1,173 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <wayland-server.h>
+#include <compositor.h>
+#include "output-registry.h"
+#include "ww-test.h"
+
+struct ww_output_registry_test {
+    struct weston_compositor compositor;
+    struct ww_output_registry registry;
+    int created;
+    int moved;
+    int destroyed;
+};
+
+struct ww_output_registry_test_state {
+    struct weston_output *output;
+    int moved;
+};
+
+static void
+_ww_output_registry_test_created(void *data, struct weston_output *output, void *state_)
+{
+    struct ww_output_registry_test *self = data;
+    struct ww_output_registry_test_state *state = state_;
+
+    ww_test_check(state->output == NULL);
+    state->output = output;
+    ++self->created;
+}
+
+static void
+_ww_output_registry_test_moved(void *data, struct weston_output *output, void *state_)
+{
+    struct ww_output_registry_test *self = data;
+    struct ww_output_registry_test_state *state = state_;
+
+    ww_test_check(state->output == output);
+    ++state->moved;
+    ++self->moved;
+}
+
+static void
+_ww_output_registry_test_destroyed(void *data, struct weston_output *output, void *state_)
+{
+    struct ww_output_registry_test *self = data;
+    struct ww_output_registry_test_state *state = state_;
+
+    ww_test_check(state->output == output);
+    ++self->destroyed;
+}
+
+static const struct ww_output_registry_interface _ww_output_registry_test_interface = {
+    .created = _ww_output_registry_test_created,
+    .moved = _ww_output_registry_test_moved,
+    .destroyed = _ww_output_registry_test_destroyed,
+};
+
+int
+main(void)
+{
+    static struct ww_output_registry_test self;
+    static struct weston_output outputs[4];
+    struct ww_output_registry_test_state *state, *first;
+    size_t i;
+    int count;
+
+    wl_list_init(&self.compositor.output_list);
+    wl_signal_init(&self.compositor.output_created_signal);
+    wl_signal_init(&self.compositor.output_moved_signal);
+    wl_signal_init(&self.compositor.output_destroyed_signal);
+
+    outputs[0].id = 0;
+    outputs[1].id = 3;
+    outputs[2].id = WW_OUTPUT_REGISTRY_MAX;
+    outputs[3].id = 3;
+
+    /* Outputs already there are picked up by init */
+    wl_list_insert(&self.compositor.output_list, &outputs[0].link);
+    ww_output_registry_init(&self.registry, &self.compositor, sizeof(struct ww_output_registry_test_state), &_ww_output_registry_test_interface, &self);
+    ww_test_check_int(self.created, 1);
+    first = ww_output_registry_get(&self.registry, &outputs[0]);
+    ww_test_check(( first != NULL ) && ( first->output == &outputs[0] ));
+
+    wl_signal_emit(&self.compositor.output_created_signal, &outputs[1]);
+    ww_test_check_int(self.created, 2);
+    state = ww_output_registry_get(&self.registry, &outputs[1]);
+    ww_test_check(( state != NULL ) && ( state != first ) && ( state->output == &outputs[1] ));
+
+    /* No second state for the same output */
+    wl_signal_emit(&self.compositor.output_created_signal, &outputs[1]);
+    ww_test_check_int(self.created, 2);
+    ww_test_check(ww_output_registry_get(&self.registry, &outputs[1]) == state);
+
+    /* Ids out of range are not tracked */
+    wl_signal_emit(&self.compositor.output_created_signal, &outputs[2]);
+    ww_test_check_int(self.created, 2);
+    ww_test_check(ww_output_registry_get(&self.registry, &outputs[2]) == NULL);
+    ww_test_check(ww_output_registry_get(&self.registry, NULL) == NULL);
+
+    wl_signal_emit(&self.compositor.output_moved_signal, &outputs[1]);
+    wl_signal_emit(&self.compositor.output_moved_signal, &outputs[2]);
+    ww_test_check_int(self.moved, 1);
+    ww_test_check_int(state->moved, 1);
+    ww_test_check_int(first->moved, 0);
+
+    count = 0;
+    ww_output_registry_for_each(state, i, &self.registry)
+    {
+        ww_test_check(( state->output == &outputs[0] ) || ( state->output == &outputs[1] ));
+        ++count;
+    }
+    ww_test_check_int(count, 2);
+
+    /* A trailing else binds to the loop body's if, not the macro's */
+    count = 0;
+    ww_output_registry_for_each(state, i, &self.registry)
+        if ( state->output == &outputs[0] )
+            ++count;
+        else
+            count += 10;
+    ww_test_check_int(count, 11);
+
+    wl_signal_emit(&self.compositor.output_destroyed_signal, &outputs[1]);
+    ww_test_check_int(self.destroyed, 1);
+    ww_test_check(ww_output_registry_get(&self.registry, &outputs[1]) == NULL);
+
+    /* Not tracked, nothing to destroy */
+    wl_signal_emit(&self.compositor.output_destroyed_signal, &outputs[2]);
+    ww_test_check_int(self.destroyed, 1);
+
+    /* A new output reusing the id gets a fresh state */
+    wl_signal_emit(&self.compositor.output_created_signal, &outputs[3]);
+    ww_test_check_int(self.created, 3);
+    state = ww_output_registry_get(&self.registry, &outputs[3]);
+    ww_test_check(( state != NULL ) && ( state->output == &outputs[3] ) && ( state->moved == 0 ));
+    ww_test_check(ww_output_registry_get(&self.registry, &outputs[1]) == NULL);
+
+    wl_signal_emit(&self.compositor.output_destroyed_signal, &outputs[3]);
+    wl_signal_emit(&self.compositor.output_destroyed_signal, &outputs[0]);
+    ww_test_check_int(self.destroyed, 3);
+
+    count = 0;
+    ww_output_registry_for_each(state, i, &self.registry)
+        ++count;
+    ww_test_check_int(count, 0);
+
+    return ww_test_result();
+}
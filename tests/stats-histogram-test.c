@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include "stats.h"
+#include "ww-test.h"
+
+/* See stats-unstable-v1.xml */
+static uint64_t
+_ww_stats_histogram_test_bucket_start(uint32_t i)
+{
+    if ( i < 8 )
+        return i;
+    return (uint64_t) ( 8 + i % 8 ) << ( i / 8 - 1 );
+}
+
+static int
+_ww_stats_histogram_test_bucket(uint64_t value)
+{
+    struct ww_stats_histogram histogram;
+    int i, found = -1;
+
+    memset(&histogram, 0, sizeof(histogram));
+    ww_stats_histogram_record(&histogram, value);
+
+    for ( i = 0 ; i < WW_STATS_HISTOGRAM_BUCKETS ; ++i )
+    {
+        if ( histogram.buckets[i] == 0 )
+            continue;
+        ww_test_check_int(histogram.buckets[i], 1);
+        ww_test_check(found < 0);
+        found = i;
+    }
+
+    return found;
+}
+
+int
+main(void)
+{
+    uint32_t i;
+
+    /* Each bucket gets its first and last value */
+    for ( i = 0 ; i < WW_STATS_HISTOGRAM_BUCKETS ; ++i )
+    {
+        uint64_t start = _ww_stats_histogram_test_bucket_start(i);
+
+        ww_test_check_int(_ww_stats_histogram_test_bucket(start), i);
+        if ( i + 1 < WW_STATS_HISTOGRAM_BUCKETS )
+            ww_test_check_int(_ww_stats_histogram_test_bucket(_ww_stats_histogram_test_bucket_start(i + 1) - 1), i);
+    }
+
+    ww_test_check_int(_ww_stats_histogram_test_bucket(UINT32_MAX), WW_STATS_HISTOGRAM_BUCKETS - 1);
+    /* Clamped rather than wrapped */
+    ww_test_check_int(_ww_stats_histogram_test_bucket((uint64_t) UINT32_MAX + 1), WW_STATS_HISTOGRAM_BUCKETS - 1);
+    ww_test_check_int(_ww_stats_histogram_test_bucket(UINT64_MAX), WW_STATS_HISTOGRAM_BUCKETS - 1);
+
+    return ww_test_result();
+}
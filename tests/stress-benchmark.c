@@ -0,0 +1,728 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include <wayland-client.h>
+#include "unstable/notification-area/notification-area-unstable-v1-client-protocol.h"
+#include "unstable/dock-manager/dock-manager-unstable-v2-client-protocol.h"
+#include "unstable/window-switcher/window-switcher-unstable-v1-client-protocol.h"
+
+/*
+ * Ramps up the surfaces of each role against a running compositor, see
+ * stress-benchmark.sh, and writes one CSV line per step:
+ * - create_ms: time to create the new surfaces, up to the roundtrip
+ * - create_cpu_ms: compositor CPU time spent meanwhile
+ * - frame_ms, frame_cpu_us: wall and compositor CPU time per repaint of
+ *   a probe window, with all the surfaces alive
+ * - bind_ms: window-switcher bind to the end of the initial announce
+ * - rss_kib: compositor resident memory
+ * CPU time is read from /proc/<pid>/schedstat, the compositor main thread
+ * Before the ramp, a few requests known to have crashed the compositor are
+ * checked, the benchmark failing if they are mishandled
+ * After the ramp, with all the surfaces still alive, the output is
+ * unplugged and plugged back through the output-hotplug module, doubling
+ * the number of cycles, in "hotplug" lines:
+ * - create_ms, create_cpu_ms: wall and compositor CPU time per cycle, up
+ *   to the output global removal and announce
+ * - frame_ms, frame_cpu_us: empty, the probe may have no output to
+ *   repaint on right after a cycle
+ */
+
+#define WW_STRESS_BENCHMARK_BUFFER_SIZE 64
+
+enum ww_stress_benchmark_kind {
+    WW_STRESS_BENCHMARK_KIND_NOTIFICATION,
+    WW_STRESS_BENCHMARK_KIND_DOCK,
+    WW_STRESS_BENCHMARK_KIND_WINDOW,
+    _WW_STRESS_BENCHMARK_KIND_SIZE
+};
+
+static const char * const _ww_stress_benchmark_kinds[_WW_STRESS_BENCHMARK_KIND_SIZE] = {
+    [WW_STRESS_BENCHMARK_KIND_NOTIFICATION] = "notification",
+    [WW_STRESS_BENCHMARK_KIND_DOCK] = "dock",
+    [WW_STRESS_BENCHMARK_KIND_WINDOW] = "window",
+};
+
+struct ww_stress_benchmark {
+    pid_t pid;
+    size_t max;
+    size_t frames;
+    size_t hotplug;
+    struct wl_display *display;
+    struct wl_registry *registry;
+    struct wl_compositor *compositor;
+    struct wl_shm *shm;
+    struct wl_shell *shell;
+    struct wl_output *output;
+    uint32_t output_name;
+    struct zww_notification_area_v1 *notification_area;
+    struct zww_dock_manager_v2 *dock_manager;
+    uint32_t window_switcher_name;
+    struct wl_buffer *buffer;
+    struct wl_buffer *dock_buffer;
+    struct wl_surface *probe;
+    bool frame_done;
+    bool announce_done;
+    struct {
+        struct zww_window_switcher_window_v1 *window;
+        bool done;
+        int32_t width;
+        int32_t height;
+    } thumbnail;
+};
+
+static uint64_t
+_ww_stress_benchmark_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t
+_ww_stress_benchmark_cpu_time(struct ww_stress_benchmark *self)
+{
+    char path[64];
+    unsigned long long ns = 0;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "/proc/%d/schedstat", (int) self->pid);
+    f = fopen(path, "r");
+    if ( f == NULL )
+        return 0;
+    if ( fscanf(f, "%llu", &ns) != 1 )
+        ns = 0;
+    fclose(f);
+
+    return ns;
+}
+
+static long
+_ww_stress_benchmark_rss(struct ww_stress_benchmark *self)
+{
+    char path[64], line[128];
+    long rss = -1;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "/proc/%d/status", (int) self->pid);
+    f = fopen(path, "r");
+    if ( f == NULL )
+        return -1;
+    while ( fgets(line, sizeof(line), f) != NULL )
+    {
+        if ( sscanf(line, "VmRSS: %ld kB", &rss) == 1 )
+            break;
+    }
+    fclose(f);
+
+    return rss;
+}
+
+static struct wl_buffer *
+_ww_stress_benchmark_create_buffer(struct ww_stress_benchmark *self, int32_t width, int32_t height, int32_t stride, uint32_t format)
+{
+    int32_t size = stride * height;
+    const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+    struct wl_shm_pool *pool;
+    struct wl_buffer *buffer;
+    char path[256];
+    void *data;
+    int fd;
+
+    if ( runtime_dir == NULL )
+        return NULL;
+
+    snprintf(path, sizeof(path), "%s/ww-stress-benchmark-XXXXXX", runtime_dir);
+    fd = mkstemp(path);
+    if ( fd < 0 )
+        return NULL;
+    unlink(path);
+
+    if ( ftruncate(fd, size) < 0 )
+    {
+        close(fd);
+        return NULL;
+    }
+
+    /* Opaque grey, the content does not matter */
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if ( data == MAP_FAILED )
+    {
+        close(fd);
+        return NULL;
+    }
+    memset(data, 0x80, size);
+    munmap(data, size);
+
+    pool = wl_shm_create_pool(self->shm, fd, size);
+    buffer = wl_shm_pool_create_buffer(pool, 0, width, height, stride, format);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+
+    return buffer;
+}
+
+static void
+_ww_stress_benchmark_shell_surface_ping(void *data, struct wl_shell_surface *shell_surface, uint32_t serial)
+{
+    wl_shell_surface_pong(shell_surface, serial);
+}
+
+static void
+_ww_stress_benchmark_shell_surface_configure(void *data, struct wl_shell_surface *shell_surface, uint32_t edges, int32_t width, int32_t height)
+{
+}
+
+static void
+_ww_stress_benchmark_shell_surface_popup_done(void *data, struct wl_shell_surface *shell_surface)
+{
+}
+
+static const struct wl_shell_surface_listener _ww_stress_benchmark_shell_surface_listener = {
+    .ping = _ww_stress_benchmark_shell_surface_ping,
+    .configure = _ww_stress_benchmark_shell_surface_configure,
+    .popup_done = _ww_stress_benchmark_shell_surface_popup_done,
+};
+
+static struct wl_surface *
+_ww_stress_benchmark_create(struct ww_stress_benchmark *self, enum ww_stress_benchmark_kind kind)
+{
+    struct wl_surface *surface = wl_compositor_create_surface(self->compositor);
+    struct wl_shell_surface *shell_surface;
+    struct wl_buffer *buffer = self->buffer;
+
+    switch ( kind )
+    {
+    case WW_STRESS_BENCHMARK_KIND_NOTIFICATION:
+        zww_notification_area_v1_create_notification(self->notification_area, surface);
+    break;
+    case WW_STRESS_BENCHMARK_KIND_DOCK:
+        /* Thin docks, so the work area is not exhausted too soon */
+        zww_dock_manager_v2_create_dock(self->dock_manager, surface, self->output, ZWW_DOCK_MANAGER_V2_POSITION_TOP);
+        buffer = self->dock_buffer;
+    break;
+    case WW_STRESS_BENCHMARK_KIND_WINDOW:
+        shell_surface = wl_shell_get_shell_surface(self->shell, surface);
+        wl_shell_surface_add_listener(shell_surface, &_ww_stress_benchmark_shell_surface_listener, self);
+        wl_shell_surface_set_toplevel(shell_surface);
+    break;
+    case _WW_STRESS_BENCHMARK_KIND_SIZE:
+    break;
+    }
+
+    wl_surface_attach(surface, buffer, 0, 0);
+    wl_surface_damage(surface, 0, 0, WW_STRESS_BENCHMARK_BUFFER_SIZE, WW_STRESS_BENCHMARK_BUFFER_SIZE);
+    wl_surface_commit(surface);
+
+    return surface;
+}
+
+static void
+_ww_stress_benchmark_frame_done(void *data, struct wl_callback *callback, uint32_t time)
+{
+    struct ww_stress_benchmark *self = data;
+
+    self->frame_done = true;
+    wl_callback_destroy(callback);
+}
+
+static const struct wl_callback_listener _ww_stress_benchmark_frame_listener = {
+    .done = _ww_stress_benchmark_frame_done,
+};
+
+static int
+_ww_stress_benchmark_frame(struct ww_stress_benchmark *self)
+{
+    struct wl_callback *callback;
+
+    self->frame_done = false;
+    callback = wl_surface_frame(self->probe);
+    wl_callback_add_listener(callback, &_ww_stress_benchmark_frame_listener, self);
+    wl_surface_attach(self->probe, self->buffer, 0, 0);
+    wl_surface_damage(self->probe, 0, 0, WW_STRESS_BENCHMARK_BUFFER_SIZE, WW_STRESS_BENCHMARK_BUFFER_SIZE);
+    wl_surface_commit(self->probe);
+
+    while ( ! self->frame_done )
+    {
+        if ( wl_display_dispatch(self->display) < 0 )
+            return -1;
+    }
+
+    return 0;
+}
+
+static void
+_ww_stress_benchmark_switcher_window(void *data, struct zww_window_switcher_v1 *switcher, struct zww_window_switcher_window_v1 *window)
+{
+    zww_window_switcher_window_v1_destroy(window);
+}
+
+static const struct zww_window_switcher_v1_listener _ww_stress_benchmark_switcher_listener = {
+    .window = _ww_stress_benchmark_switcher_window,
+};
+
+static void
+_ww_stress_benchmark_announce_done(void *data, struct wl_callback *callback, uint32_t serial)
+{
+    struct ww_stress_benchmark *self = data;
+
+    self->announce_done = true;
+    wl_callback_destroy(callback);
+}
+
+static const struct wl_callback_listener _ww_stress_benchmark_announce_listener = {
+    .done = _ww_stress_benchmark_announce_done,
+};
+
+/* A version 1 bind is announced right away, a sync is enough to wait for it */
+static int
+_ww_stress_benchmark_bind(struct ww_stress_benchmark *self)
+{
+    struct zww_window_switcher_v1 *switcher;
+    struct wl_callback *callback;
+
+    switcher = wl_registry_bind(self->registry, self->window_switcher_name, &zww_window_switcher_v1_interface, 1);
+    zww_window_switcher_v1_add_listener(switcher, &_ww_stress_benchmark_switcher_listener, self);
+
+    self->announce_done = false;
+    callback = wl_display_sync(self->display);
+    wl_callback_add_listener(callback, &_ww_stress_benchmark_announce_listener, self);
+
+    while ( ! self->announce_done )
+    {
+        if ( wl_display_dispatch(self->display) < 0 )
+            return -1;
+    }
+
+    zww_window_switcher_v1_destroy(switcher);
+    return 0;
+}
+
+static void
+_ww_stress_benchmark_window_title(void *data, struct zww_window_switcher_window_v1 *window, const char *title)
+{
+}
+
+static void
+_ww_stress_benchmark_window_app_id(void *data, struct zww_window_switcher_window_v1 *window, const char *app_id)
+{
+}
+
+static void
+_ww_stress_benchmark_window_done(void *data, struct zww_window_switcher_window_v1 *window)
+{
+}
+
+static void
+_ww_stress_benchmark_window_closed(void *data, struct zww_window_switcher_window_v1 *window)
+{
+}
+
+static void
+_ww_stress_benchmark_window_thumbnail(void *data, struct zww_window_switcher_window_v1 *window, struct wl_buffer *buffer, int32_t width, int32_t height)
+{
+    struct ww_stress_benchmark *self = data;
+
+    self->thumbnail.done = true;
+    self->thumbnail.width = width;
+    self->thumbnail.height = height;
+}
+
+static void
+_ww_stress_benchmark_window_mru_rank(void *data, struct zww_window_switcher_window_v1 *window, uint32_t rank)
+{
+}
+
+static void
+_ww_stress_benchmark_window_geometry(void *data, struct zww_window_switcher_window_v1 *window, int32_t x, int32_t y, int32_t width, int32_t height)
+{
+}
+
+static void
+_ww_stress_benchmark_window_state(void *data, struct zww_window_switcher_window_v1 *window, uint32_t state)
+{
+}
+
+static void
+_ww_stress_benchmark_window_output_enter(void *data, struct zww_window_switcher_window_v1 *window, struct wl_output *output)
+{
+}
+
+static void
+_ww_stress_benchmark_window_output_leave(void *data, struct zww_window_switcher_window_v1 *window, struct wl_output *output)
+{
+}
+
+static const struct zww_window_switcher_window_v1_listener _ww_stress_benchmark_window_listener = {
+    .title = _ww_stress_benchmark_window_title,
+    .app_id = _ww_stress_benchmark_window_app_id,
+    .done = _ww_stress_benchmark_window_done,
+    .closed = _ww_stress_benchmark_window_closed,
+    .thumbnail = _ww_stress_benchmark_window_thumbnail,
+    .mru_rank = _ww_stress_benchmark_window_mru_rank,
+    .geometry = _ww_stress_benchmark_window_geometry,
+    .state = _ww_stress_benchmark_window_state,
+    .output_enter = _ww_stress_benchmark_window_output_enter,
+    .output_leave = _ww_stress_benchmark_window_output_leave,
+};
+
+static void
+_ww_stress_benchmark_thumbnail_switcher_window(void *data, struct zww_window_switcher_v1 *switcher, struct zww_window_switcher_window_v1 *window)
+{
+    struct ww_stress_benchmark *self = data;
+
+    if ( self->thumbnail.window != NULL )
+    {
+        zww_window_switcher_window_v1_destroy(window);
+        return;
+    }
+
+    self->thumbnail.window = window;
+    zww_window_switcher_window_v1_add_listener(window, &_ww_stress_benchmark_window_listener, self);
+}
+
+static void
+_ww_stress_benchmark_thumbnail_switcher_selected(void *data, struct zww_window_switcher_v1 *switcher, uint32_t rank)
+{
+}
+
+static void
+_ww_stress_benchmark_thumbnail_switcher_count(void *data, struct zww_window_switcher_v1 *switcher, uint32_t count)
+{
+}
+
+static void
+_ww_stress_benchmark_thumbnail_switcher_search_result(void *data, struct zww_window_switcher_v1 *switcher, struct zww_window_switcher_window_v1 *window)
+{
+}
+
+static void
+_ww_stress_benchmark_thumbnail_switcher_search_done(void *data, struct zww_window_switcher_v1 *switcher)
+{
+}
+
+static const struct zww_window_switcher_v1_listener _ww_stress_benchmark_thumbnail_switcher_listener = {
+    .window = _ww_stress_benchmark_thumbnail_switcher_window,
+    .selected = _ww_stress_benchmark_thumbnail_switcher_selected,
+    .count = _ww_stress_benchmark_thumbnail_switcher_count,
+    .search_result = _ww_stress_benchmark_thumbnail_switcher_search_result,
+    .search_done = _ww_stress_benchmark_thumbnail_switcher_search_done,
+};
+
+/*
+ * A stride of 1 byte per pixel is valid for libwayland, but too small for
+ * a thumbnail, which must be refused rather than written past the pool
+ */
+static int
+_ww_stress_benchmark_check_thumbnail(struct ww_stress_benchmark *self)
+{
+    struct zww_window_switcher_v1 *switcher;
+    struct wl_buffer *buffer;
+    int i;
+
+    /* Make sure the probe window is mapped */
+    if ( ( _ww_stress_benchmark_frame(self) < 0 ) || ( _ww_stress_benchmark_frame(self) < 0 ) )
+        return -1;
+
+    switcher = wl_registry_bind(self->registry, self->window_switcher_name, &zww_window_switcher_v1_interface, 2);
+    zww_window_switcher_v1_add_listener(switcher, &_ww_stress_benchmark_thumbnail_switcher_listener, self);
+
+    /* Version 2 binds are announced from an idle callback */
+    for ( i = 0 ; ( i < 10 ) && ( self->thumbnail.window == NULL ) ; ++i )
+    {
+        if ( wl_display_roundtrip(self->display) < 0 )
+            return -1;
+    }
+    if ( self->thumbnail.window == NULL )
+    {
+        fprintf(stderr, "The probe window was not announced\n");
+        return -1;
+    }
+
+    buffer = _ww_stress_benchmark_create_buffer(self, WW_STRESS_BENCHMARK_BUFFER_SIZE, WW_STRESS_BENCHMARK_BUFFER_SIZE, WW_STRESS_BENCHMARK_BUFFER_SIZE, WL_SHM_FORMAT_ARGB8888);
+    if ( buffer == NULL )
+        return -1;
+
+    self->thumbnail.done = false;
+    zww_window_switcher_window_v1_get_thumbnail(self->thumbnail.window, buffer);
+    while ( ! self->thumbnail.done )
+    {
+        if ( wl_display_dispatch(self->display) < 0 )
+        {
+            fprintf(stderr, "Lost the compositor on a thumbnail with a short stride\n");
+            return -1;
+        }
+    }
+
+    if ( ( self->thumbnail.width != 0 ) || ( self->thumbnail.height != 0 ) )
+    {
+        fprintf(stderr, "A thumbnail was drawn in a buffer with a short stride\n");
+        return -1;
+    }
+
+    wl_buffer_destroy(buffer);
+    zww_window_switcher_window_v1_destroy(self->thumbnail.window);
+    self->thumbnail.window = NULL;
+    zww_window_switcher_v1_destroy(switcher);
+
+    return 0;
+}
+
+static int
+_ww_stress_benchmark_step(struct ww_stress_benchmark *self, enum ww_stress_benchmark_kind kind, size_t count, size_t *current)
+{
+    uint64_t start, cpu, create, create_cpu, frame, frame_cpu, bind;
+    size_t i;
+
+    start = _ww_stress_benchmark_now();
+    cpu = _ww_stress_benchmark_cpu_time(self);
+    for ( ; *current < count ; ++*current )
+        _ww_stress_benchmark_create(self, kind);
+    if ( wl_display_roundtrip(self->display) < 0 )
+        return -1;
+    create = _ww_stress_benchmark_now() - start;
+    create_cpu = _ww_stress_benchmark_cpu_time(self) - cpu;
+
+    /* Let the compositor settle first */
+    if ( _ww_stress_benchmark_frame(self) < 0 )
+        return -1;
+
+    start = _ww_stress_benchmark_now();
+    cpu = _ww_stress_benchmark_cpu_time(self);
+    for ( i = 0 ; i < self->frames ; ++i )
+    {
+        if ( _ww_stress_benchmark_frame(self) < 0 )
+            return -1;
+    }
+    frame = _ww_stress_benchmark_now() - start;
+    frame_cpu = _ww_stress_benchmark_cpu_time(self) - cpu;
+
+    bind = _ww_stress_benchmark_now();
+    if ( _ww_stress_benchmark_bind(self) < 0 )
+        return -1;
+    bind = _ww_stress_benchmark_now() - bind;
+
+    printf("%s,%zu,%.3f,%.3f,%.3f,%.1f,%.3f,%ld\n", _ww_stress_benchmark_kinds[kind], count,
+        create / 1e6, create_cpu / 1e6,
+        frame / 1e6 / self->frames, frame_cpu / 1e3 / self->frames,
+        bind / 1e6, _ww_stress_benchmark_rss(self));
+    fflush(stdout);
+
+    return 0;
+}
+
+/* The hotplug signals are handled asynchronously, so poll for the globals */
+static int
+_ww_stress_benchmark_hotplug_wait(struct ww_stress_benchmark *self, bool plugged)
+{
+    int i;
+
+    for ( i = 0 ; i < 5000 ; ++i )
+    {
+        if ( wl_display_roundtrip(self->display) < 0 )
+            return -1;
+        if ( ( self->output != NULL ) == plugged )
+            return 0;
+        usleep(1000);
+    }
+
+    fprintf(stderr, "The output was not %s, is the output-hotplug module loaded?\n", plugged ? "plugged back" : "unplugged");
+    return -1;
+}
+
+static int
+_ww_stress_benchmark_hotplug_step(struct ww_stress_benchmark *self, size_t count, size_t *current)
+{
+    uint64_t start, cpu, cycle, cycle_cpu, bind;
+    size_t cycles = count - *current;
+
+    start = _ww_stress_benchmark_now();
+    cpu = _ww_stress_benchmark_cpu_time(self);
+    for ( ; *current < count ; ++*current )
+    {
+        if ( ( kill(self->pid, SIGUSR1) < 0 ) || ( _ww_stress_benchmark_hotplug_wait(self, false) < 0 ) )
+            return -1;
+        if ( ( kill(self->pid, SIGUSR2) < 0 ) || ( _ww_stress_benchmark_hotplug_wait(self, true) < 0 ) )
+            return -1;
+    }
+    cycle = _ww_stress_benchmark_now() - start;
+    cycle_cpu = _ww_stress_benchmark_cpu_time(self) - cpu;
+
+    bind = _ww_stress_benchmark_now();
+    if ( _ww_stress_benchmark_bind(self) < 0 )
+        return -1;
+    bind = _ww_stress_benchmark_now() - bind;
+
+    printf("hotplug,%zu,%.3f,%.3f,,,%.3f,%ld\n", count,
+        cycle / 1e6 / cycles, cycle_cpu / 1e6 / cycles,
+        bind / 1e6, _ww_stress_benchmark_rss(self));
+    fflush(stdout);
+
+    return 0;
+}
+
+static void
+_ww_stress_benchmark_registry_global(void *data, struct wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    struct ww_stress_benchmark *self = data;
+
+    if ( strcmp(interface, wl_compositor_interface.name) == 0 )
+        self->compositor = wl_registry_bind(registry, name, &wl_compositor_interface, 1);
+    else if ( strcmp(interface, wl_shm_interface.name) == 0 )
+        self->shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+    else if ( strcmp(interface, wl_shell_interface.name) == 0 )
+        self->shell = wl_registry_bind(registry, name, &wl_shell_interface, 1);
+    else if ( ( strcmp(interface, wl_output_interface.name) == 0 ) && ( self->output == NULL ) )
+    {
+        self->output = wl_registry_bind(registry, name, &wl_output_interface, 1);
+        self->output_name = name;
+    }
+    else if ( strcmp(interface, zww_notification_area_v1_interface.name) == 0 )
+        self->notification_area = wl_registry_bind(registry, name, &zww_notification_area_v1_interface, 1);
+    else if ( strcmp(interface, zww_dock_manager_v2_interface.name) == 0 )
+        self->dock_manager = wl_registry_bind(registry, name, &zww_dock_manager_v2_interface, 1);
+    else if ( strcmp(interface, zww_window_switcher_v1_interface.name) == 0 )
+        self->window_switcher_name = name;
+}
+
+static void
+_ww_stress_benchmark_registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+    struct ww_stress_benchmark *self = data;
+
+    if ( ( self->output == NULL ) || ( name != self->output_name ) )
+        return;
+
+    wl_output_destroy(self->output);
+    self->output = NULL;
+    self->output_name = 0;
+}
+
+static const struct wl_registry_listener _ww_stress_benchmark_registry_listener = {
+    .global = _ww_stress_benchmark_registry_global,
+    .global_remove = _ww_stress_benchmark_registry_global_remove,
+};
+
+int
+main(int argc, char *argv[])
+{
+    struct ww_stress_benchmark self_ = { .max = 4096, .frames = 60, .hotplug = 64 }, *self = &self_;
+    enum ww_stress_benchmark_kind kind;
+    size_t count, current[_WW_STRESS_BENCHMARK_KIND_SIZE] = { 0 }, cycles = 0;
+
+    if ( ( argc < 2 ) || ( argc > 5 ) )
+    {
+        fprintf(stderr, "Usage: %s <compositor pid> [max surfaces per role] [frames per step] [max hotplug cycles]\n", argv[0]);
+        return 2;
+    }
+    self->pid = strtol(argv[1], NULL, 10);
+    if ( argc > 2 )
+        self->max = strtoul(argv[2], NULL, 10);
+    if ( argc > 3 )
+        self->frames = strtoul(argv[3], NULL, 10);
+    if ( self->frames == 0 )
+        self->frames = 1;
+    if ( argc > 4 )
+        self->hotplug = strtoul(argv[4], NULL, 10);
+
+    if ( _ww_stress_benchmark_cpu_time(self) == 0 )
+    {
+        fprintf(stderr, "Could not read the compositor CPU time from /proc/%d/schedstat\n", (int) self->pid);
+        return 1;
+    }
+
+    self->display = wl_display_connect(NULL);
+    if ( self->display == NULL )
+    {
+        fprintf(stderr, "Could not connect to the compositor\n");
+        return 1;
+    }
+
+    self->registry = wl_display_get_registry(self->display);
+    wl_registry_add_listener(self->registry, &_ww_stress_benchmark_registry_listener, self);
+    wl_display_roundtrip(self->display);
+
+    if ( ( self->compositor == NULL ) || ( self->shm == NULL ) || ( self->shell == NULL ) || ( self->output == NULL ) || ( self->notification_area == NULL ) || ( self->dock_manager == NULL ) || ( self->window_switcher_name == 0 ) )
+    {
+        fprintf(stderr, "Missing globals, are all the modules loaded?\n");
+        return 1;
+    }
+
+    self->buffer = _ww_stress_benchmark_create_buffer(self, WW_STRESS_BENCHMARK_BUFFER_SIZE, WW_STRESS_BENCHMARK_BUFFER_SIZE, WW_STRESS_BENCHMARK_BUFFER_SIZE * 4, WL_SHM_FORMAT_XRGB8888);
+    self->dock_buffer = _ww_stress_benchmark_create_buffer(self, WW_STRESS_BENCHMARK_BUFFER_SIZE, 1, WW_STRESS_BENCHMARK_BUFFER_SIZE * 4, WL_SHM_FORMAT_XRGB8888);
+    if ( ( self->buffer == NULL ) || ( self->dock_buffer == NULL ) )
+    {
+        fprintf(stderr, "Could not create the buffer\n");
+        return 1;
+    }
+
+    /* The probe is itself a window, counted as such */
+    self->probe = _ww_stress_benchmark_create(self, WW_STRESS_BENCHMARK_KIND_WINDOW);
+    current[WW_STRESS_BENCHMARK_KIND_WINDOW] = 1;
+
+    if ( _ww_stress_benchmark_check_thumbnail(self) < 0 )
+        return 1;
+
+    printf("role,count,create_ms,create_cpu_ms,frame_ms,frame_cpu_us,bind_ms,rss_kib\n");
+    for ( kind = 0 ; kind < _WW_STRESS_BENCHMARK_KIND_SIZE ; ++kind )
+    {
+        for ( count = 1 ; count <= self->max ; count *= 2 )
+        {
+            if ( count < current[kind] )
+                continue;
+            if ( _ww_stress_benchmark_step(self, kind, count, &current[kind]) < 0 )
+            {
+                fprintf(stderr, "Lost the compositor at %zu %s surfaces\n", count, _ww_stress_benchmark_kinds[kind]);
+                return 1;
+            }
+        }
+    }
+
+    for ( count = 1 ; count <= self->hotplug ; count *= 2 )
+    {
+        if ( _ww_stress_benchmark_hotplug_step(self, count, &cycles) < 0 )
+        {
+            fprintf(stderr, "Lost the compositor at %zu output hotplug cycles\n", count);
+            return 1;
+        }
+    }
+
+    wl_display_disconnect(self->display);
+
+    return 0;
+}
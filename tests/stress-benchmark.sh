@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# Runs the stress benchmark against a headless Weston loading the
+# notification-area, dock-manager and window-switcher plugins, and the
+# output-hotplug benchmark module to unplug and plug back the output
+#
+# Usage: stress-benchmark.sh <benchmark> <module directory> [max surfaces per role] [frames per step] [max hotplug cycles]
+# Set WESTON to use another weston binary
+#
+
+set -e
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 <benchmark> <module directory> [max surfaces per role] [frames per step] [max hotplug cycles]" >&2
+    exit 2
+fi
+
+benchmark="$1"
+moduledir="$2"
+shift 2
+
+runtime_dir=$(mktemp -d)
+chmod 700 "${runtime_dir}"
+export XDG_RUNTIME_DIR="${runtime_dir}"
+socket=ww-stress-benchmark
+
+modules=
+for module in notification-area dock-manager window-switcher output-hotplug; do
+    modules="${modules}${modules:+,}${moduledir}/${module}.so"
+done
+
+"${WESTON:-weston}" --backend=headless-backend.so --socket="${socket}" --no-config --modules="${modules}" &
+pid=$!
+trap 'kill ${pid} 2>/dev/null; wait ${pid} 2>/dev/null; rm -rf "${runtime_dir}"' EXIT
+
+tries=0
+while [ ! -S "${runtime_dir}/${socket}" ]; do
+    tries=$((tries + 1))
+    if [ ${tries} -gt 100 ] || ! kill -0 ${pid} 2>/dev/null; then
+        echo "Weston did not start" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+WAYLAND_DISPLAY="${socket}" "${benchmark}" ${pid} "$@"
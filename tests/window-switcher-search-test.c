@@ -0,0 +1,211 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "window-switcher-search.h"
+#include "ww-test.h"
+
+#define WW_SEARCH_TEST_DOCUMENTS 300
+#define WW_SEARCH_TEST_ITERATIONS 100000
+#define WW_SEARCH_TEST_STRING_MAX 24
+
+/* A small alphabet so queries actually hit */
+static const char _ww_search_test_alphabet[] = "abcdeABC xyz";
+
+struct ww_search_test_document {
+    struct weston_window_switcher_search_document *document;
+    char title[WW_SEARCH_TEST_STRING_MAX + 1];
+    char app_id[WW_SEARCH_TEST_STRING_MAX + 1];
+    unsigned hits;
+};
+
+static struct ww_search_test_document _ww_search_test_documents[WW_SEARCH_TEST_DOCUMENTS];
+
+static void
+_ww_search_test_random_string(char *string, size_t max)
+{
+    size_t length = rand() % ( max + 1 ), i;
+
+    for ( i = 0 ; i < length ; ++i )
+        string[i] = _ww_search_test_alphabet[rand() % ( sizeof(_ww_search_test_alphabet) - 1 )];
+    string[length] = '\0';
+}
+
+static bool
+_ww_search_test_contains(const char *haystack, const char *needle)
+{
+    size_t length = strlen(needle), i, j;
+
+    for ( i = 0 ; haystack[i] != '\0' ; ++i )
+    {
+        for ( j = 0 ; j < length ; ++j )
+        {
+            if ( tolower((unsigned char) haystack[i + j]) != tolower((unsigned char) needle[j]) )
+                break;
+        }
+        if ( j == length )
+            return true;
+    }
+    return ( length == 0 );
+}
+
+static void
+_ww_search_test_result(void *document_data, void *data)
+{
+    struct ww_search_test_document *document = document_data;
+
+    ++document->hits;
+}
+
+static void
+_ww_search_test_query(struct weston_window_switcher_search *search, const char *query)
+{
+    size_t i;
+
+    for ( i = 0 ; i < WW_SEARCH_TEST_DOCUMENTS ; ++i )
+        _ww_search_test_documents[i].hits = 0;
+
+    weston_window_switcher_search_query(search, query, _ww_search_test_result, NULL);
+
+    for ( i = 0 ; i < WW_SEARCH_TEST_DOCUMENTS ; ++i )
+    {
+        struct ww_search_test_document *document = &_ww_search_test_documents[i];
+        unsigned expected = 0;
+
+        if ( document->document != NULL )
+            expected = ( _ww_search_test_contains(document->title, query) || _ww_search_test_contains(document->app_id, query) ) ? 1 : 0;
+
+        if ( document->hits != expected )
+            fprintf(stderr, "query \"%s\" on \"%s\" \"%s\": %u results, expected %u\n", query, document->title, document->app_id, document->hits, expected);
+        ww_test_check(document->hits == expected);
+    }
+}
+
+static void
+_ww_search_test_fixed(void)
+{
+    struct weston_window_switcher_search *search = weston_window_switcher_search_new();
+    struct ww_search_test_document *terminal = &_ww_search_test_documents[0];
+    struct ww_search_test_document *browser = &_ww_search_test_documents[1];
+
+    ww_test_check(search != NULL);
+    if ( search == NULL )
+        return;
+
+    strcpy(terminal->title, "user@host: ~/src");
+    strcpy(terminal->app_id, "org.example.Terminal");
+    terminal->document = weston_window_switcher_search_add(search, terminal);
+    weston_window_switcher_search_update(search, terminal->document, terminal->title, terminal->app_id);
+
+    strcpy(browser->title, "Search results - Browser");
+    strcpy(browser->app_id, "");
+    browser->document = weston_window_switcher_search_add(search, browser);
+    weston_window_switcher_search_update(search, browser->document, browser->title, NULL);
+
+    _ww_search_test_query(search, "");
+    _ww_search_test_query(search, "s");
+    _ww_search_test_query(search, "TERM");
+    _ww_search_test_query(search, "browser");
+    _ww_search_test_query(search, "src");
+    _ww_search_test_query(search, "nothing");
+    /* Title and app_id do not run into each other */
+    _ww_search_test_query(search, "srcorg");
+
+    strcpy(terminal->title, "vim");
+    weston_window_switcher_search_update(search, terminal->document, terminal->title, terminal->app_id);
+    _ww_search_test_query(search, "src");
+    _ww_search_test_query(search, "vim");
+
+    weston_window_switcher_search_remove(search, browser->document);
+    browser->document = NULL;
+    _ww_search_test_query(search, "browser");
+
+    weston_window_switcher_search_free(search);
+    terminal->document = NULL;
+}
+
+/* Random churn checked against a plain scan */
+static void
+_ww_search_test_random(void)
+{
+    struct weston_window_switcher_search *search = weston_window_switcher_search_new();
+    size_t i;
+
+    ww_test_check(search != NULL);
+    if ( search == NULL )
+        return;
+
+    srand(1);
+    for ( i = 0 ; i < WW_SEARCH_TEST_ITERATIONS ; ++i )
+    {
+        struct ww_search_test_document *document = &_ww_search_test_documents[rand() % WW_SEARCH_TEST_DOCUMENTS];
+
+        if ( document->document == NULL )
+        {
+            document->document = weston_window_switcher_search_add(search, document);
+            ww_test_check(document->document != NULL);
+            _ww_search_test_random_string(document->title, WW_SEARCH_TEST_STRING_MAX);
+            _ww_search_test_random_string(document->app_id, 8);
+            weston_window_switcher_search_update(search, document->document, document->title, document->app_id);
+        }
+        else if ( rand() % 4 == 0 )
+        {
+            weston_window_switcher_search_remove(search, document->document);
+            document->document = NULL;
+        }
+        else
+        {
+            _ww_search_test_random_string(document->title, WW_SEARCH_TEST_STRING_MAX);
+            weston_window_switcher_search_update(search, document->document, document->title, document->app_id);
+        }
+
+        if ( i % 100 == 0 )
+        {
+            char query[6];
+
+            _ww_search_test_random_string(query, 5);
+            _ww_search_test_query(search, query);
+        }
+    }
+
+    weston_window_switcher_search_free(search);
+    for ( i = 0 ; i < WW_SEARCH_TEST_DOCUMENTS ; ++i )
+        _ww_search_test_documents[i].document = NULL;
+}
+
+int
+main(void)
+{
+    _ww_search_test_fixed();
+    _ww_search_test_random();
+
+    return ww_test_result();
+}
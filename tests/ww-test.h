@@ -0,0 +1,62 @@
+/*
+ * Copyright © 2013-2016 Quentin “Sardem FF7” Glidic
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __WW_TEST_H__
+#define __WW_TEST_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Tiny helpers for the compositor-free unit tests, run by make check
+ * A failed check is reported and the test goes on, main() returns
+ * ww_test_result() so one run shows every failure
+ */
+
+static int ww_test_failures = 0;
+
+#define ww_test_check(cond) \
+    do { \
+        if ( ! ( cond ) ) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++ww_test_failures; \
+        } \
+    } while ( 0 )
+
+#define ww_test_check_int(value, expected) \
+    do { \
+        long long _value = (value), _expected = (expected); \
+        if ( _value != _expected ) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s == %lld, expected %lld\n", __FILE__, __LINE__, #value, _value, _expected); \
+            ++ww_test_failures; \
+        } \
+    } while ( 0 )
+
+static inline int
+ww_test_result(void)
+{
+    return ( ww_test_failures == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif /* __WW_TEST_H__ */